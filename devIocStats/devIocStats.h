@@ -27,8 +27,16 @@
 #define LOAD_TYPE	1
 #define FD_TYPE		2
 #define CA_TYPE		3
-#define STATIC_TYPE	4
-#define TOTAL_TYPES	5
+#define IO_TYPE		4
+#define TOP_TYPE	5
+#define STATIC_TYPE	6
+#define TOTAL_TYPES	7
+
+/* Number of entries in the top process lists */
+#define TOP_PROCS	10
+
+/* Number of entries in the stalled thread list */
+#define STALL_THREADS	10
 
 /* Names of environment variables (may be redefined in OSD include) */
 #define STARTUP  "STARTUP"
@@ -36,7 +44,11 @@
 #define ENGINEER "ENGINEER"
 #define LOCATION "LOCATION"
 
+#include <stddef.h>
+#include <epicsTime.h>
+
 #include "devIocStatsOSD.h"
+#include "devIocStatsShm.h"
 
 typedef int clustInfo[CLUSTSIZES][4];
 
@@ -59,12 +71,103 @@ typedef struct {
     int oerrors;
 } ifErrInfo;
 
+typedef struct {
+    double readBytes;		/* bytes/sec through read() and friends */
+    double writeBytes;		/* bytes/sec through write() and friends */
+    double readCalls;		/* read syscalls/sec */
+    double writeCalls;		/* write syscalls/sec */
+    double diskReadBytes;	/* bytes/sec fetched from the storage layer */
+    double diskWriteBytes;	/* bytes/sec sent to the storage layer */
+    double cpuDelay;		/* ms/sec spent waiting on a run queue */
+    double blkioDelay;		/* ms/sec spent waiting for block I/O */
+    double swapinDelay;		/* ms/sec spent waiting for swap-in */
+} ioInfo;
+
 typedef struct {
     long noOfCpus;
     double cpuLoad;
     double iocLoad;
+    double iocRunqWait;		/* ms/sec IOC threads spent waiting for a CPU */
 } loadInfo;
 
+typedef struct {
+    double loadAvg[3];		/* 1/5/15 min load average per CPU */
+    int runnable;		/* tasks currently runnable */
+    int total;			/* tasks on the system */
+    double runqWait;		/* ms/sec per CPU tasks spent waiting to run */
+} sysLoadInfo;
+
+typedef struct {
+    int pid;
+    char comm[16];
+    double cpuLoad;		/* percent of one CPU */
+    double rss;			/* bytes */
+} procInfo;
+
+typedef struct {
+    int nCpu;			/* valid entries in byCpu */
+    int nMem;			/* valid entries in byMem */
+    procInfo byCpu[TOP_PROCS];
+    procInfo byMem[TOP_PROCS];
+} topProcInfo;
+
+typedef struct {
+    char name[16];
+    char state;			/* 'D' uninterruptible sleep, 'R' runnable */
+    char wchan[32];		/* kernel function the thread waits in, "-" if none */
+    double seconds;		/* stalled for */
+} stallThread;
+
+typedef struct {
+    int n;			/* stalled threads */
+    int nList;			/* valid entries in list, longest stall first */
+    stallThread list[STALL_THREADS];
+} stallInfo;
+
+typedef struct {
+    int tid;
+    char name[16];
+    int policy;			/* SCHED_* value */
+    char policyName[12];
+    int priority;		/* real-time priority, 0 for the other policies */
+    int realtime;		/* policy is FIFO, RR or DEADLINE */
+    char affinity[32];		/* list of allowed CPUs, e.g. "0-3,6" */
+    double timerSlack;		/* ns, -1 if unknown */
+} rtThread;
+
+typedef struct {
+    int threads;
+    int rtThreads;		/* threads with a real-time policy */
+    double memLocked;		/* bytes (VmLck) */
+    double memRss;		/* bytes */
+    double rtprioLimit;		/* RLIMIT_RTPRIO, -1 if unlimited */
+    double memlockLimit;	/* RLIMIT_MEMLOCK in bytes, -1 if unlimited */
+    int preemptRt;		/* kernel is PREEMPT_RT */
+} rtInfo;
+
+/* Other IOCs on the same host (host statistics daemon) */
+#define IOC_NAME_SIZE 40
+
+typedef struct {
+    int pid;
+    char name[IOC_NAME_SIZE];
+} iocProcId;
+
+typedef struct {
+    double cpuTime;		/* sec of CPU time used so far */
+    double rss;			/* bytes */
+    int threads;
+    int fds;			/* -1 if not accessible */
+    double readBytes;		/* bytes read so far */
+    double writeBytes;		/* bytes written so far */
+    double startTime;		/* to detect pid reuse, arbitrary units */
+} procStats;
+
+typedef struct {
+    int threads;		/* threads of this IOC */
+    double threadLimit;		/* max processes + threads of the user, 0 if none */
+} limitInfo;
+
 /* Functions (API) for OSD layer */
 /* All funcs return 0 (OK) / -1 (ERROR) */
 
@@ -72,6 +175,10 @@ typedef struct {
 extern int devIocStatsInitCpuUsage (void);
 extern int devIocStatsGetCpuUsage (loadInfo *pval);
 
+/* System Load Average and Run Queue */
+extern int devIocStatsInitSysLoad (void);
+extern int devIocStatsGetSysLoad (sysLoadInfo *pval);
+
 /* IOC Load (CPU utilization by this IOC) */
 extern int devIocStatsInitCpuUtilization (loadInfo *pval);
 extern int devIocStatsGetCpuUtilization (loadInfo *pval);
@@ -88,10 +195,65 @@ extern int devIocStatsGetMemUsage (memInfo *pval);
 extern int devIocStatsInitWorkspaceUsage (void);
 extern int devIocStatsGetWorkspaceUsage (memInfo *pval);
 
+/* Process I/O and Delay Accounting */
+extern int devIocStatsInitIOUsage (void);
+extern int devIocStatsGetIOUsage (ioInfo *pval);
+
+/* Top foreign processes on the system */
+extern int devIocStatsInitTopProcs (void);
+extern int devIocStatsGetTopProcs (topProcInfo *pval);
+
+/* Processes of other IOCs */
+/* FindIocs returns the number of entries found, GetProcStats 0 / -1 */
+extern int devIocStatsFindIocs (const char *pattern, iocProcId *pval, int max);
+extern int devIocStatsGetProcStats (int pid, procStats *pval);
+
+/* Thread Count and Resource Limits */
+extern int devIocStatsInitLimits (void);
+extern int devIocStatsGetLimits (limitInfo *pval);
+/* Bytes the IOC may use, the physical memory if no limit */
+extern int devIocStatsGetMemLimit (double *pval);
+
+/* Shared Memory Statistics Segment */
+extern int devIocStatsInitShm (void);
+extern int devIocStatsPublishShm (const iocStatsShm *pval);
+
+/* Clocks for timing the collectors (seconds) */
+extern double devIocStatsClock (void);
+extern double devIocStatsThreadCpuTime (void);
+extern double devIocStatsProcessCpuTime (void);
+extern void devIocStatsSleepUntil (double deadline);
+
+/* Location of /proc and clock of the collectors, replaceable to replay
+   recorded snapshots (devIocStatsReplay.c).  Process-wide, so the Set
+   functions fail (-1) while collectors are running; "" and < 0 restore. */
+extern const char *devIocStatsProcPath (char *buf, size_t size, const char *fmt, ...);
+extern void devIocStatsGetTime (epicsTimeStamp *pts);
+extern int devIocStatsNoOfCpus (void);
+extern int devIocStatsReplaying (void);
+extern int devIocStatsSetProcRoot (const char *dir);
+extern int devIocStatsSetTime (double seconds);
+extern int devIocStatsCollectorsRunning (void);
+
 /* Suspended Tasks */
 extern int devIocStatsInitSuspTasks (void);
 extern int devIocStatsGetSuspTasks (int *pval);
 
+/* Real-time Readiness; GetRtThreads returns the number of entries */
+extern int devIocStatsInitRtInfo (void);
+extern int devIocStatsGetRtInfo (rtInfo *pval);
+extern int devIocStatsGetRtThreads (rtThread *pval, int max);
+
+/* CPU affinity ("0-3,6") and scheduling policy ("FIFO", ...) of a
+   thread, tid 0 = the calling thread; empty strings keep the current */
+extern int devIocStatsCheckPlacement (const char *cpus, const char *policy);
+extern int devIocStatsPlaceThread (int tid, const char *cpus,
+    const char *policy, int priority);
+
+/* Threads stalled for at least minSeconds */
+extern int devIocStatsInitStalls (void);
+extern int devIocStatsGetStalls (double minSeconds, stallInfo *pval);
+
 /* Cluster Info */
 extern int devIocStatsInitClusterInfo (void);
 extern int devIocStatsGetClusterInfo (int pool, clustInfo *pval);
@@ -118,3 +280,109 @@ extern int devIocStatsGetPwd (char **pval);
 extern int devIocStatsGetHostname (char **pval);
 extern int devIocStatsGetPID (double *proc_id);
 extern int devIocStatsGetPPID (double *proc_id);
+
+/* Collect host-wide statistics (set to 0 when a host statistics daemon
+   does that for all IOCs on the host) */
+extern int devIocStatsHostStats;
+
+/* Publish the statistics in a shared memory segment (see devIocStatsShm.h) */
+extern int devIocStatsShm;
+
+/* Functions shared between the device support parts (devIocStatsAnalog.c) */
+#include <dbScan.h>
+
+extern long devIocStatsIointInfo (int type, int cmd, IOSCANPVT *iopvt);
+extern void devIocStatsReadTopProcs (topProcInfo *pval);
+extern void devIocStatsReadStalls (stallInfo *pval);
+
+typedef struct {
+    const char *name;
+    int type;
+    double value;
+} statsValue;
+extern int devIocStatsReadAll (statsValue *pval, int max);
+extern int devIocStatsNumValues (void);
+extern void devIocStatsLockCollectors (void);
+extern void devIocStatsUnlockCollectors (void);
+
+/* Statistics of other support modules, each with its own collector;
+   the ai parm is the provider name (see devIocStatsRegisterProvider) */
+#define PROVIDER_NAME_SIZE 40
+typedef int (*devIocStatsCollectFunc) (void *arg, double *pval);
+extern int devIocStatsRegisterProvider (const char *name,
+    devIocStatsCollectFunc collect, void *arg, double period);
+extern int devIocStatsNumTypes (void);
+extern void devIocStatsResetMarks (void);
+extern int devIocStatsAddBurst (const char *parm, const char *op,
+    double threshold, double period, double hold);
+extern int devIocStatsTimerProbe (double period, int priority);
+
+/* Any ai parm by name, for other parts of the module; NULL before iocInit
+   or if unknown */
+extern void *devIocStatsFindParm (const char *parm);
+extern double devIocStatsParmValue (void *parm);
+
+/* Flight recorder (devIocStatsRecorder.c); file NULL = the configured
+   file, "" = stdout */
+extern int devIocStatsRecorderDump (const char *file, const char *reason);
+extern void devIocStatsRecorderRequest (const char *reason);
+
+/* Wakeup latency probe (devIocStatsLatency.c); bucket i of the
+   histogram counts wakeups less than 2^(i+1) us late, the last all */
+#define LATENCY_BUCKETS 20
+typedef struct {
+    double period;		/* of the probe, sec */
+    double count;
+    double min;			/* sec */
+    double max;
+    double sum;
+    double hist[LATENCY_BUCKETS];
+} latencyInfo;
+extern void devIocStatsReadLatency (latencyInfo *pval);
+extern void devIocStatsResetLatency (void);
+extern double devIocStatsLatencyPercentile (const latencyInfo *pl, double p);
+
+/* Placement rules for threads by name pattern (devIocStatsPlacement.c) */
+extern int devIocStatsPlaceThreads (const char *pattern, const char *cpus,
+    const char *policy, int priority);
+
+/* OpenMetrics endpoint (devIocStatsHttp.c), iocsh iocStatsHttpStart */
+extern int devIocStatsHttpStart (int port, const char *bindaddr);
+
+/* Provider reading a number from a text file (devIocStatsProbe.c) */
+extern int devIocStatsAddFileProbe (const char *name, const char *path,
+    const char *pattern, int field, const char *mode, double period);
+
+/* Robust growth trend over a sliding window (devIocStatsTrend.c) */
+#define TREND_SAMPLES 120
+#define TREND_NEVER 1e6		/* hours left if not growing */
+typedef struct {
+    double window;		/* seconds covered by the samples */
+    int n;			/* valid samples */
+    int next;			/* next sample to write */
+    double time[TREND_SAMPLES];
+    double value[TREND_SAMPLES];
+    double slope;		/* per second */
+} trendInfo;
+extern void devIocStatsTrendInit (trendInfo *pt, double window);
+extern int devIocStatsTrendAdd (trendInfo *pt, double time, double value);
+extern double devIocStatsTrendHoursLeft (const trendInfo *pt, double value,
+    double limit);
+
+/* Sliding window of the leak trends (hours) */
+extern int devIocStatsTrendHours;
+
+/* Time after which a thread counts as stalled (seconds) */
+extern double devIocStatsStallSeconds;
+
+/* The IOC is meant to run real-time (rt_problems is 0 if not set) */
+extern int devIocStatsRealTime;
+
+/* Timing of the device support reads */
+#define READ_AI		0
+#define READ_STRINGIN	1
+#define READ_WAVEFORM	2
+#define READ_TYPES	3
+extern void devIocStatsReadTime (int dev, double start);
+extern void devIocStatsShow (int level);
+extern void devIocStatsShowRead (int dev);
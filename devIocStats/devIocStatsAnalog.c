@@ -65,8 +65,18 @@
                 sys_cpuload	 - estimated percent CPU load on the system
                 ioc_cpuload      - estimated percent CPU utilization by this IOC
                 no_of_cpus       - number of CPU cores on the system
+                ioc_runq_wait    - ms/sec IOC threads spent waiting for a CPU
+                load_avg_1       - 1 minute load average per CPU
+                load_avg_5       - 5 minute load average per CPU
+                load_avg_15      - 15 minute load average per CPU
+                runnable_tasks   - number of runnable tasks on the system
+                total_tasks      - number of tasks on the system
+                sys_runq_wait    - ms/sec per CPU tasks spent waiting to run
               ( cpu		 - same as ioc_cpuload [for compatibility] )
                 suspended_tasks	 - number of suspended tasks
+                stalled_threads  - number of IOC threads in uninterruptible
+                                   sleep or runnable without progress for
+                                   devIocStatsStallSeconds (Linux)
 		fd		 - number of file descriptors currently in use
 		max_fd		 - max number of file descriptors
 		ca_clients	 - number of current CA clients
@@ -83,6 +93,68 @@
                 workspace_alloc_bytes - number of RAM workspace allocated bytes
                 workspace_free_bytes  - number of RAM workspace free bytes
                 workspace_total_bytes - number of RAM workspace total bytes
+                io_read_rate     - bytes/sec read by this IOC (all read calls)
+                io_write_rate    - bytes/sec written by this IOC (all write calls)
+                io_read_calls    - read syscalls/sec
+                io_write_calls   - write syscalls/sec
+                io_disk_read_rate  - bytes/sec fetched from storage
+                io_disk_write_rate - bytes/sec sent to storage
+                cpu_delay        - ms/sec spent waiting on a CPU run queue
+                blkio_delay      - ms/sec spent waiting for block I/O
+                swapin_delay     - ms/sec spent waiting for swap-in
+                mem_growth       - allocated_bytes growth, bytes/hour
+                mem_hours_left   - hours until mem_limit is reached
+                mem_limit        - cgroup/RLIMIT_AS limit or physical memory
+                fd_growth        - fd growth per hour
+                fd_hours_left    - hours until maxfd is reached
+                threads          - number of threads of this IOC
+                thread_limit     - RLIMIT_NPROC (0 = none)
+                thread_growth    - thread growth per hour
+                thread_hours_left - hours until thread_limit is reached
+                                   (growth: robust trend over
+                                   devIocStatsTrendHours, hours_left:
+                                   1e6 if not growing)
+                rt_threads       - threads with a real-time policy (Linux)
+                mem_locked       - bytes locked in RAM (VmLck)
+                mem_locked_pct   - mem_locked in percent of the RSS
+                rtprio_limit     - RLIMIT_RTPRIO (-1 = unlimited)
+                memlock_limit    - RLIMIT_MEMLOCK in bytes (-1 = unlimited)
+                preempt_rt       - 1 if the kernel is PREEMPT_RT
+                rt_problems      - number of real-time problems (no real-time
+                                   threads, memory not locked, no PREEMPT_RT
+                                   kernel), 0 unless devIocStatsRealTime=1
+                latency_min      - min wakeup latency (us) of the latency
+                                   probe (iocStatsLatencyProbe)
+                latency_avg      - average wakeup latency (us)
+                latency_p99      - 99th percentile wakeup latency (us)
+                latency_max      - max wakeup latency (us)
+                latency_samples  - number of wakeups measured
+                <parm>:rate      - change per second of <parm> (any of the
+                                   above or a provider)
+                <parm>:delta     - change since the last collection
+                <parm>:ewma(<tau>) - moving average with time constant <tau>
+                <parm>:pct_of(<parm2>) - <parm> in percent of <parm2>
+                <parm>:hwm|lwm   - maximum|minimum of <parm> since reset;
+                                   TSE=-2 gives its time stamp
+                <parm>:hwm_time|lwm_time - time of the maximum|minimum
+                                   (POSIX seconds)
+                <coll>_scan_time[_mean|_max] - run time (sec) of a collector,
+                                   <coll> = memory, cpu, fd, ca, io, top
+                <coll>_scan_cpu[_mean|_max]  - CPU time (sec) of a collector
+                <coll>_scan_late[_mean|_max] - how late (sec) the timer of a
+                                   collector fired
+                timer_probe_late[_mean|_max] - how late (sec) the probe timer
+                                   on a shared timer queue fired
+                                   (iocStatsTimerProbe)
+                <coll>_scan_period - effective period (sec) of a collector,
+                                   shorter during a burst (iocStatsBurst)
+                <dset>_read_time[_mean|_max] - time (sec) of a device support
+                                   read, <dset> = ai, stringin, waveform
+                <provider>       - value of a statistics provider registered
+                                   with devIocStatsRegisterProvider(), also
+                                   <provider>_scan_time|cpu[_mean|_max]
+                probe <name>     - value of a file probe added with
+                                   iocStatsAddFileProbe (same as <name>)
 
 	ai (DTYP="IOC stats clusts"):
                 clust_info <pool> <index> <type> where:
@@ -96,6 +168,15 @@
 		fdScanRate	 - max rate at which file descriptors can be counted
 		cpuScanRate	 - max rate at which cpu load can be calculated
 		caConnScanRate	 - max rate at which CA connections can be calculated
+		io_scan_rate	 - max rate at which I/O statistics can be calculated
+		top_scan_rate	 - max rate at which the top process lists
+				   (waveform records) can be updated
+		<provider>_scan_rate - period of a statistics provider
+
+	bo (DTYP="IOC stats"):
+		hwm_reset	 - restart all :hwm and :lwm parms
+		recorder_dump	 - dump the flight recorder to its file
+		latency_reset	 - clear the wakeup latency statistics
 
 	* scan rates are all in seconds
 
@@ -104,14 +185,22 @@
 		20 - cpu scan rate
 		10 - fd scan rate
 		15 - CA scan rate
+		10 - I/O scan rate
+		30 - top process scan rate
 */
 
 #include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
 #include <time.h>
+#include <math.h>
 
 #include <epicsThread.h>
 #include <epicsTimer.h>
 #include <epicsMutex.h>
+#include <gpHash.h>
+#include <epicsString.h>
+#include <errlog.h>
 
 #include <rsrv.h>
 #include <dbAccess.h>
@@ -121,11 +210,18 @@
 #include <menuConvert.h>
 #include <aiRecord.h>
 #include <aoRecord.h>
+#include <boRecord.h>
 #include <recGbl.h>
+#include <iocsh.h>
 #include <epicsExport.h>
 
 #include "devIocStats.h"
 
+/* Base 3.14 has no name for TSE -2 */
+#ifndef epicsTimeEventDeviceTime
+#define epicsTimeEventDeviceTime (-2)
+#endif
+
 struct aStats
 {
 	long		number;
@@ -143,6 +239,8 @@ struct pvtArea
 {
 	int index;
 	int type;
+	int timing;	/* TIMING_NONE: index into statsGetParms */
+	int stat;	/* TIMING_DERIVED: 1 = time of the water mark */
 };
 typedef struct pvtArea pvtArea;
 
@@ -164,6 +262,86 @@ struct validGetParms
 };
 typedef struct validGetParms validGetParms;
 
+/* Run time statistics of the collectors and reads (seconds) */
+struct timingInfo
+{
+	unsigned long count;
+	double last;
+	double sum;
+	double max;
+};
+typedef struct timingInfo timingInfo;
+
+#define TIMING_NONE	0
+#define TIMING_RUN	1	/* collector elapsed time */
+#define TIMING_CPU	2	/* collector CPU time */
+#define TIMING_READ	3	/* device support read time */
+#define TIMING_DERIVED	4	/* derived value, index into derived[] */
+#define TIMING_PERIOD	5	/* effective collector period */
+#define TIMING_LATE	6	/* collector timer lateness */
+#define TIMING_PROBE	7	/* lateness of the shared queue probe timer */
+
+#define STAT_LAST	0
+#define STAT_MEAN	1
+#define STAT_MAX	2
+
+/* Statistics registered by other support modules, each has its own
+   collector (scan type TOTAL_TYPES + index) */
+#define MAX_PROVIDERS	64
+#define MAX_TYPES	(TOTAL_TYPES + MAX_PROVIDERS)
+
+struct providerInfo
+{
+	char name[PROVIDER_NAME_SIZE];
+	devIocStatsCollectFunc collect;
+	void *arg;
+	double value;
+};
+typedef struct providerInfo providerInfo;
+
+/* Values derived from a parm, "<parm>:<suffix>", computed by the collector
+   of the parm and shared by all records with the same parm string */
+#define MAX_DERIVED	256
+#define DERIVED_RATE	0	/* change per second */
+#define DERIVED_DELTA	1	/* change since the last collection */
+#define DERIVED_EWMA	2	/* exponentially weighted moving average */
+#define DERIVED_PCT_OF	3	/* percent of another parm */
+#define DERIVED_HWM	4	/* maximum since reset */
+#define DERIVED_LWM	5	/* minimum since reset */
+
+struct derivedInfo
+{
+	char *parm;
+	int kind;
+	int type;		/* collector of the base parm */
+	int index;		/* base parm, statsGetParms or providers */
+	int refType;		/* reference parm of pct_of */
+	int refIndex;
+	double tau;		/* EWMA time constant (sec) */
+	int valid;
+	double last;		/* base value and time of the last collection */
+	double lastTime;
+	double value;
+	epicsTimeStamp when;	/* of the high/low water mark */
+};
+typedef struct derivedInfo derivedInfo;
+
+/* Burst policies: while <parm> is above/below the threshold, its
+   collector runs every <period> seconds, until <hold> seconds after */
+#define MAX_BURST	32
+#define BURST_PARM_SIZE	80
+
+struct burstInfo
+{
+	char parm[BURST_PARM_SIZE];
+	int above;
+	double threshold;
+	double period;
+	double hold;
+	pvtArea *pvt;		/* NULL until resolved in ai_init */
+};
+typedef struct burstInfo burstInfo;
+
 struct scanInfo
 {
 	IOSCANPVT ioscan;
@@ -171,9 +349,32 @@ struct scanInfo
 	volatile int total;			/* total users connected */
 	volatile int on;			/* watch dog on? */
 	double rate_sec;	/* seconds */
+	double due;		/* devIocStatsClock() when the watchdog should fire */
+	timingInfo late;	/* seconds the runs started late */
+	double period;		/* effective period, shorter in burst mode */
+	double burstRate;	/* burst period, 0 = no burst */
+	double burstUntil;	/* devIocStatsClock() when the burst ends */
+	timingInfo runtime;
+	timingInfo cputime;
 };
 typedef struct scanInfo scanInfo;
 
+/* Leak trends of the allocated memory, fds and threads; the trend is
+   only used by the collector thread */
+#define LEAK_MEM	0
+#define LEAK_FD		1
+#define LEAK_THREAD	2
+#define LEAK_TYPES	3
+
+struct leakInfo
+{
+	trendInfo trend;
+	double growth;		/* per hour */
+	double hoursLeft;	/* until the limit is reached */
+};
+typedef struct leakInfo leakInfo;
+
+static long ai_report(int level);
 static long ai_init(int pass);
 static long ai_init_record(aiRecord*);
 static long ai_read(aiRecord*);
@@ -186,6 +387,9 @@ static long ai_clusts_read(aiRecord *);
 static long ao_init_record(aoRecord* pr);
 static long ao_write(aoRecord*);
 
+static long bo_init_record(boRecord* pr);
+static long bo_write(boRecord*);
+
 static void statsFreeBytes(double*);
 static void statsFreeBlocks(double*);
 static void statsAllocBytes(double*);
@@ -198,7 +402,15 @@ static void statsWSTotalBytes(double*);
 static void statsCpuUsage(double*);
 static void statsCpuUtilization(double*);
 static void statsNoOfCpus(double*);
+static void statsIocRunqWait(double*);
+static void statsLoadAvg1(double*);
+static void statsLoadAvg5(double*);
+static void statsLoadAvg15(double*);
+static void statsRunnableTasks(double*);
+static void statsTotalTasks(double*);
+static void statsSysRunqWait(double*);
 static void statsSuspendedTasks(double*);
+static void statsStalledThreads(double*);
 static void statsFdUsage(double*);
 static void statsFdMax(double*);
 static void statsCAConnects(double*);
@@ -212,6 +424,36 @@ static void statsIFOErrs(double *);
 static void statsRecords(double *);
 static void statsPID(double *);
 static void statsPPID(double *);
+static void statsIOReadRate(double *);
+static void statsIOWriteRate(double *);
+static void statsIOReadCalls(double *);
+static void statsIOWriteCalls(double *);
+static void statsIODiskReadRate(double *);
+static void statsIODiskWriteRate(double *);
+static void statsCpuDelay(double *);
+static void statsBlkIODelay(double *);
+static void statsSwapinDelay(double *);
+static void statsMemGrowth(double *);
+static void statsMemHoursLeft(double *);
+static void statsMemLimit(double *);
+static void statsFdGrowth(double *);
+static void statsFdHoursLeft(double *);
+static void statsThreads(double *);
+static void statsThreadLimit(double *);
+static void statsRtThreads(double *);
+static void statsMemLocked(double *);
+static void statsMemLockedPct(double *);
+static void statsRtprioLimit(double *);
+static void statsMemlockLimit(double *);
+static void statsPreemptRt(double *);
+static void statsRtProblems(double *);
+static void statsLatencyMin(double *);
+static void statsLatencyAvg(double *);
+static void statsLatencyP99(double *);
+static void statsLatencyMax(double *);
+static void statsLatencySamples(double *);
+static void statsThreadGrowth(double *);
+static void statsThreadHoursLeft(double *);
 
 struct {
 	char *name;
@@ -221,6 +463,8 @@ struct {
 	{ "cpu_scan_rate",	20.0 },
 	{ "fd_scan_rate",	10.0 },
 	{ "ca_scan_rate", 	15.0 },
+	{ "io_scan_rate",	10.0 },
+	{ "top_scan_rate",	30.0 },
 	{ NULL,			0.0  },
 };
 
@@ -238,7 +482,15 @@ static validGetParms statsGetParms[]={
         { "ioc_cpuload",		statsCpuUtilization,	LOAD_TYPE },
         { "cpu",			statsCpuUtilization,    LOAD_TYPE },
         { "no_of_cpus",			statsNoOfCpus,		LOAD_TYPE },
+        { "ioc_runq_wait",		statsIocRunqWait,	LOAD_TYPE },
+        { "load_avg_1",			statsLoadAvg1,		LOAD_TYPE },
+        { "load_avg_5",			statsLoadAvg5,		LOAD_TYPE },
+        { "load_avg_15",		statsLoadAvg15,		LOAD_TYPE },
+        { "runnable_tasks",		statsRunnableTasks,	LOAD_TYPE },
+        { "total_tasks",		statsTotalTasks,	LOAD_TYPE },
+        { "sys_runq_wait",		statsSysRunqWait,	LOAD_TYPE },
         { "suspended_tasks",		statsSuspendedTasks,	LOAD_TYPE },
+        { "stalled_threads",		statsStalledThreads,	LOAD_TYPE },
 	{ "fd",				statsFdUsage,		FD_TYPE },
         { "maxfd",			statsFdMax,	        FD_TYPE },
 	{ "ca_clients",			statsCAClients,		CA_TYPE },
@@ -252,22 +504,73 @@ static validGetParms statsGetParms[]={
 	{ "records",			statsRecords,           STATIC_TYPE },
 	{ "proc_id",			statsPID,               STATIC_TYPE },
 	{ "parent_proc_id",		statsPPID,              STATIC_TYPE },
+	{ "io_read_rate",		statsIOReadRate,	IO_TYPE },
+	{ "io_write_rate",		statsIOWriteRate,	IO_TYPE },
+	{ "io_read_calls",		statsIOReadCalls,	IO_TYPE },
+	{ "io_write_calls",		statsIOWriteCalls,	IO_TYPE },
+	{ "io_disk_read_rate",		statsIODiskReadRate,	IO_TYPE },
+	{ "io_disk_write_rate",		statsIODiskWriteRate,	IO_TYPE },
+	{ "cpu_delay",			statsCpuDelay,		IO_TYPE },
+	{ "blkio_delay",		statsBlkIODelay,	IO_TYPE },
+	{ "swapin_delay",		statsSwapinDelay,	IO_TYPE },
+	{ "mem_growth",			statsMemGrowth,		MEMORY_TYPE },
+	{ "mem_hours_left",		statsMemHoursLeft,	MEMORY_TYPE },
+	{ "mem_limit",			statsMemLimit,		MEMORY_TYPE },
+	{ "fd_growth",			statsFdGrowth,		FD_TYPE },
+	{ "fd_hours_left",		statsFdHoursLeft,	FD_TYPE },
+	{ "threads",			statsThreads,		FD_TYPE },
+	{ "thread_limit",		statsThreadLimit,	FD_TYPE },
+	{ "rt_threads",			statsRtThreads,		FD_TYPE },
+	{ "mem_locked",			statsMemLocked,		FD_TYPE },
+	{ "mem_locked_pct",		statsMemLockedPct,	FD_TYPE },
+	{ "rtprio_limit",		statsRtprioLimit,	FD_TYPE },
+	{ "memlock_limit",		statsMemlockLimit,	FD_TYPE },
+	{ "preempt_rt",			statsPreemptRt,		FD_TYPE },
+	{ "rt_problems",		statsRtProblems,	FD_TYPE },
+	{ "latency_min",		statsLatencyMin,	LOAD_TYPE },
+	{ "latency_avg",		statsLatencyAvg,	LOAD_TYPE },
+	{ "latency_p99",		statsLatencyP99,	LOAD_TYPE },
+	{ "latency_max",		statsLatencyMax,	LOAD_TYPE },
+	{ "latency_samples",		statsLatencySamples,	LOAD_TYPE },
+	{ "thread_growth",		statsThreadGrowth,	FD_TYPE },
+	{ "thread_hours_left",		statsThreadHoursLeft,	FD_TYPE },
 	{ NULL,NULL,0 }
 };
 
-aStats devAiStats={ 6,NULL,ai_init,ai_init_record,ai_ioint_info,ai_read,NULL };
+aStats devAiStats={ 6,ai_report,ai_init,ai_init_record,ai_ioint_info,ai_read,NULL };
 epicsExportAddress(dset,devAiStats);
 aStats devAoStats={ 6,NULL,NULL,ao_init_record,NULL,ao_write,NULL };
 epicsExportAddress(dset,devAoStats);
+aStats devBoStats={ 5,NULL,NULL,bo_init_record,NULL,bo_write,NULL };
+epicsExportAddress(dset,devBoStats);
 aStats devAiClusts = {6,NULL,ai_clusts_init,ai_clusts_init_record,NULL,ai_clusts_read,NULL };
 epicsExportAddress(dset,devAiClusts);
 
 static memInfo meminfo = {0.0,0.0,0.0,0.0,0.0,0.0};
 static memInfo workspaceinfo = {0.0,0.0,0.0,0.0,0.0,0.0};
-static scanInfo scan[TOTAL_TYPES] = {{0}};
+static scanInfo scan[MAX_TYPES] = {{0}};
+static providerInfo providers[MAX_PROVIDERS];
+static int nProviders = 0;
+static derivedInfo derived[MAX_DERIVED];
+static int nDerived = 0;
+static burstInfo bursts[MAX_BURST];
+static int nBursts = 0;
+static int aiInitDone = 0;
+static void *parmHash = NULL;	/* parm name -> statsGetParms/providers entry */
+static timingInfo readtime[READ_TYPES] = {{0}};
+static char *statSuffix[] = { "", "_mean", "_max" };
+static char *readNames[READ_TYPES] = { "ai", "stringin", "waveform" };
 static fdInfo fdusage = {0,0};
-static loadInfo loadinfo = {1,0.,0.};
+static limitInfo limitinfo = {0,0.};
+static double memlimit = 0.0;
+static rtInfo rtinfo;
+static leakInfo leak[LEAK_TYPES];
+static loadInfo loadinfo = {1,0.,0.,0.};
+static sysLoadInfo sysloadinfo = {{0.,0.,0.},0,0,0.};
+static topProcInfo topprocs;
+static ioInfo iousage = {0.,0.,0.,0.,0.,0.,0.,0.,0.};
 static int susptasknumber = 0;
+static stallInfo stallinfo;
 static int recordnumber = 0;
 static clustInfo clustinfo[2] = {{{0}},{{0}}};
 static int mbufnumber[2] = {0,0};
@@ -275,7 +578,25 @@ static ifErrInfo iferrors = {0,0};
 static unsigned cainfo_clients = 0;
 static unsigned cainfo_connex  = 0;
 static epicsTimerQueueId timerQ = 0;
+static epicsTimerId timerProbe = NULL;
+static double timerProbePeriod = 0.0;	/* 0 = no probe */
+static int timerProbePriority;
+static double timerProbeDue;
+static timingInfo timerProbeLate = {0};
 static epicsMutexId scan_mutex;
+static epicsMutexId collect_mutex;	/* held while a collector runs */
+
+int devIocStatsHostStats = 1;
+epicsExportAddress(int, devIocStatsHostStats);
+int devIocStatsShm = 0;
+epicsExportAddress(int, devIocStatsShm);
+int devIocStatsTrendHours = 24;
+epicsExportAddress(int, devIocStatsTrendHours);
+double devIocStatsStallSeconds = 30.0;
+epicsExportAddress(double, devIocStatsStallSeconds);
+int devIocStatsRealTime = 0;
+epicsExportAddress(int, devIocStatsRealTime);
+static int shmPublish = 0;
 
 /* ---------------------------------------------------------------------- */
 
@@ -301,8 +622,220 @@ wdogCreate(void (*fn)(int), long arg)
 	return epicsTimerQueueCreateTimer(timerQ, (void (*)(void*))fn, (void*)arg);
 }
 
+static void timing_add(timingInfo *pt, double value)
+{
+	pt->last = value;
+	pt->sum += value;
+	if (value > pt->max) pt->max = value;
+	pt->count++;
+}
+
+static double timing_get(const timingInfo *pt, int stat)
+{
+	switch (stat) {
+	case STAT_MEAN: return pt->count ? pt->sum / pt->count : 0.0;
+	case STAT_MAX:  return pt->max;
+	default:        return pt->last;
+	}
+}
+
+/*
+ * Probe timer on the shared timer queue of a priority (the one drivers
+ * get from epicsTimerQueueAllocate(1, priority)), to see whether the
+ * queue's thread is starved.
+ */
+static void timer_probe(void *unused)
+{
+	double now = devIocStatsClock();
+
+	epicsMutexLock(scan_mutex);
+	timing_add(&timerProbeLate, now > timerProbeDue ? now - timerProbeDue : 0.0);
+	epicsMutexUnlock(scan_mutex);
+	timerProbeDue = now + timerProbePeriod;
+	epicsTimerStartDelay(timerProbe, timerProbePeriod);
+}
+
+static void timer_probe_start(void)
+{
+	epicsTimerQueueId queue = epicsTimerQueueAllocate(1, timerProbePriority);
+
+	timerProbe = epicsTimerQueueCreateTimer(queue, timer_probe, NULL);
+	timerProbeDue = devIocStatsClock() + timerProbePeriod;
+	epicsTimerStartDelay(timerProbe, timerProbePeriod);
+}
+
+static void parm_hash_add(const char *name, void *pvtid, void *entry)
+{
+	GPHENTRY *pgph = gphAdd(parmHash, name, pvtid);
+
+	if (pgph) pgph->userPvt = entry;
+}
+
+/* Base name of a collector ("memory", "cpu", ..., provider name), NULL if none */
+static const char *collector_name(int type, int *len)
+{
+	if (type >= TOTAL_TYPES) {
+		*len = strlen(providers[type - TOTAL_TYPES].name);
+		return providers[type - TOTAL_TYPES].name;
+	}
+	if (!parmTypes[type].name) return NULL;
+	/* "memory_scan_rate" -> "memory" */
+	*len = strlen(parmTypes[type].name) - 10;
+	return parmTypes[type].name;
+}
+
+static void scan_start(int type)
+{
+	double period = scan[type].rate_sec;
+
+	if (scan[type].burstRate > 0) {
+		if (devIocStatsClock() < scan[type].burstUntil) {
+			if (scan[type].burstRate < period) period = scan[type].burstRate;
+		} else {
+			scan[type].burstRate = 0;
+		}
+	}
+	scan[type].period = period;
+	scan[type].due = devIocStatsClock() + period;
+	epicsTimerStartDelay(scan[type].wd, period);
+}
+
+/* Copy the current values into the shared memory segment.
+   Only called from the timer queue thread, so there is a single writer. */
+static void shm_publish(void)
+{
+    iocStatsShm snap;
+    epicsTimeStamp now;
+    char *name = getenv("IOC");
+    int i;
+
+    memset(&snap, 0, sizeof(snap));
+    epicsTimeGetCurrent(&now);
+    snap.updateTime = (double)now.secPastEpoch + POSIX_TIME_AT_EPICS_EPOCH
+                      + now.nsec / 1e9;
+    if (name) strncpy(snap.name, name, IOCSTATS_SHM_NAME_SIZE - 1);
+    epicsMutexLock(scan_mutex);
+    snap.noOfCpus      = loadinfo.noOfCpus;
+    snap.iocCpuLoad    = loadinfo.iocLoad;
+    snap.sysCpuLoad    = loadinfo.cpuLoad;
+    snap.memAlloc      = meminfo.numBytesAlloc;
+    snap.memFree       = meminfo.numBytesFree;
+    snap.memTotal      = meminfo.numBytesTotal;
+    snap.fdUsed        = fdusage.used;
+    snap.fdMax         = fdusage.max;
+    snap.caClients     = cainfo_clients;
+    snap.caConnections = cainfo_connex;
+    snap.ioReadRate    = iousage.readBytes;
+    snap.ioWriteRate   = iousage.writeBytes;
+    for (i = 0; i < TOTAL_TYPES; i++)
+        if (scan[i].on && scan[i].late.last > snap.scanLateness)
+            snap.scanLateness = scan[i].late.last;
+    epicsMutexUnlock(scan_mutex);
+    devIocStatsPublishShm(&snap);
+}
+
+/* Value of a base parm, call with scan_mutex held */
+static double parm_value(int type, int index)
+{
+    double val = 0.0;
+
+    if (type >= TOTAL_TYPES) val = providers[index].value;
+    else statsGetParms[index].func(&val);
+    return val;
+}
+
+/* Update the values derived from the parms of a collector */
+static void derived_update(int type)
+{
+    double now = devIocStatsClock();
+    double val, ref, dt;
+    derivedInfo *pd;
+    int i;
+
+    epicsMutexLock(scan_mutex);
+    for (i = 0; i < nDerived; i++) {
+        pd = &derived[i];
+        if (pd->type != type) continue;
+        val = parm_value(pd->type, pd->index);
+        dt = now - pd->lastTime;
+        switch (pd->kind) {
+        case DERIVED_RATE:
+            if (pd->valid && dt > 0) pd->value = (val - pd->last) / dt;
+            break;
+        case DERIVED_DELTA:
+            if (pd->valid) pd->value = val - pd->last;
+            break;
+        case DERIVED_EWMA:
+            if (pd->valid) pd->value += (val - pd->value) * (1.0 - exp(-dt / pd->tau));
+            else pd->value = val;
+            break;
+        case DERIVED_PCT_OF:
+            ref = parm_value(pd->refType, pd->refIndex);
+            pd->value = ref ? 100.0 * val / ref : 0.0;
+            break;
+        case DERIVED_HWM:
+        case DERIVED_LWM:
+            if (!pd->valid || (pd->kind == DERIVED_HWM ? val > pd->value :
+                                                         val < pd->value)) {
+                pd->value = val;
+                epicsTimeGetCurrent(&pd->when);
+            }
+            break;
+        }
+        pd->last = val;
+        pd->lastTime = now;
+        pd->valid = 1;
+    }
+    epicsMutexUnlock(scan_mutex);
+}
+
+static double pvt_value(const pvtArea *pvt);
+static pvtArea *parm_pvt(const char *parm);
+
+/* Start or extend a burst of the collector if one of its policies fires */
+static void burst_check(int type)
+{
+    double now = devIocStatsClock();
+    burstInfo *pb;
+    double val;
+    int i;
+
+    epicsMutexLock(scan_mutex);
+    for (i = 0; i < nBursts; i++) {
+        pb = &bursts[i];
+        if (!pb->pvt || pb->pvt->type != type) continue;
+        val = pvt_value(pb->pvt);
+        if (pb->above ? val <= pb->threshold : val >= pb->threshold) continue;
+        if (scan[type].burstRate <= 0 || pb->period < scan[type].burstRate)
+            scan[type].burstRate = pb->period;
+        if (now + pb->hold > scan[type].burstUntil)
+            scan[type].burstUntil = now + pb->hold;
+    }
+    epicsMutexUnlock(scan_mutex);
+}
+
+static void leak_update(int which, double value, double limit)
+{
+    leakInfo *pl = &leak[which];
+
+    devIocStatsTrendAdd(&pl->trend, devIocStatsClock(), value);
+    epicsMutexLock(scan_mutex);
+    pl->growth = pl->trend.slope * 3600.0;
+    pl->hoursLeft = devIocStatsTrendHoursLeft(&pl->trend, value, limit);
+    epicsMutexUnlock(scan_mutex);
+}
+
 static void scan_time(int type)
 {
+    double start = devIocStatsClock();
+    double cpuStart = devIocStatsThreadCpuTime();
+    double runtime, cputime;
+
+    epicsMutexLock(scan_mutex);
+    timing_add(&scan[type].late, start > scan[type].due ? start - scan[type].due : 0.0);
+    epicsMutexUnlock(scan_mutex);
+
+    epicsMutexLock(collect_mutex);
     switch(type) {
       case MEMORY_TYPE:
       {
@@ -310,7 +843,12 @@ static void scan_time(int type)
 	memInfo   workspaceinfo_local = {0.0,0.0,0.0,0.0,0.0,0.0};
 	int       mbufnumber_local[2] = {0,0};
 	ifErrInfo iferrors_local = {0,0};
-        devIocStatsGetMemUsage(&meminfo_local);
+        double    memlimit_local = 0.0;
+        int       memok;
+        memok = (devIocStatsGetMemUsage(&meminfo_local) == 0);
+        /* No OSD limit: all of the host's memory */
+        if (devIocStatsGetMemLimit(&memlimit_local) != 0 || memlimit_local == 0.0)
+            memlimit_local = meminfo_local.numBytesTotal;
         devIocStatsGetWorkspaceUsage(&workspaceinfo_local);
 	devIocStatsGetClusterUsage(SYS_POOL, &mbufnumber_local[SYS_POOL]);
 	devIocStatsGetClusterUsage(DATA_POOL, &mbufnumber_local[DATA_POOL]);
@@ -321,31 +859,56 @@ static void scan_time(int type)
 	mbufnumber[SYS_POOL]  = mbufnumber_local[SYS_POOL];
 	mbufnumber[DATA_POOL] = mbufnumber_local[DATA_POOL];
 	iferrors              = iferrors_local;
+	memlimit              = memlimit_local;
 	devIocStatsGetClusterInfo(SYS_POOL, &clustinfo[SYS_POOL]);
 	devIocStatsGetClusterInfo(DATA_POOL, &clustinfo[DATA_POOL]);
         epicsMutexUnlock(scan_mutex);
+        if (memok)
+            leak_update(LEAK_MEM, meminfo_local.numBytesAlloc, memlimit_local);
 	break;
       }
       case LOAD_TYPE:
       {
-	loadInfo loadinfo_local = {1,0.,0.};
+	loadInfo loadinfo_local = {1,0.,0.,0.};
+	sysLoadInfo sysloadinfo_local = {{0.,0.,0.},0,0,0.};
 	int      susptasknumber_local = 0;
-        devIocStatsGetCpuUsage(&loadinfo_local);
+	stallInfo stallinfo_local;
+        int      sysloadok = 1;
+	memset(&stallinfo_local, 0, sizeof(stallinfo_local));
+        if (devIocStatsHostStats) {
+            devIocStatsGetCpuUsage(&loadinfo_local);
+            sysloadok = (devIocStatsGetSysLoad(&sysloadinfo_local) == 0);
+        }
         devIocStatsGetCpuUtilization(&loadinfo_local);
         devIocStatsGetSuspTasks(&susptasknumber_local);
+        devIocStatsGetStalls(devIocStatsStallSeconds, &stallinfo_local);
         epicsMutexLock(scan_mutex);
 	loadinfo       = loadinfo_local;
+        if (sysloadok) sysloadinfo = sysloadinfo_local;
 	susptasknumber = susptasknumber_local;
+	stallinfo      = stallinfo_local;
         epicsMutexUnlock(scan_mutex);
 	break;
       }
       case FD_TYPE:
       {
 	fdInfo   fdusage_local = {0,0};
-        devIocStatsGetFDUsage(&fdusage_local);
+	limitInfo limitinfo_local = {0,0.};
+	rtInfo   rtinfo_local;
+        int      fdok, limitok;
+        fdok = (devIocStatsGetFDUsage(&fdusage_local) == 0);
+        limitok = (devIocStatsGetLimits(&limitinfo_local) == 0);
+        if (devIocStatsGetRtInfo(&rtinfo_local) != 0)
+            memset(&rtinfo_local, 0, sizeof(rtinfo_local));
         epicsMutexLock(scan_mutex);
 	fdusage = fdusage_local;
+	limitinfo = limitinfo_local;
+	rtinfo = rtinfo_local;
         epicsMutexUnlock(scan_mutex);
+        if (fdok)
+            leak_update(LEAK_FD, fdusage_local.used, fdusage_local.max);
+        if (limitok)
+            leak_update(LEAK_THREAD, limitinfo_local.threads, limitinfo_local.threadLimit);
 	break;
       }
       case CA_TYPE:
@@ -359,12 +922,51 @@ static void scan_time(int type)
         epicsMutexUnlock(scan_mutex);
 	break;
       }
+      case IO_TYPE:
+      {
+        ioInfo iousage_local = {0.,0.,0.,0.,0.,0.,0.,0.,0.};
+        devIocStatsGetIOUsage(&iousage_local);
+        epicsMutexLock(scan_mutex);
+        iousage = iousage_local;
+        epicsMutexUnlock(scan_mutex);
+        break;
+      }
+      case TOP_TYPE:
+      {
+        topProcInfo topprocs_local;
+        memset(&topprocs_local, 0, sizeof(topprocs_local));
+        devIocStatsGetTopProcs(&topprocs_local);
+        epicsMutexLock(scan_mutex);
+        topprocs = topprocs_local;
+        epicsMutexUnlock(scan_mutex);
+        break;
+      }
       default:
+        if (type >= TOTAL_TYPES) {
+            providerInfo *pp = &providers[type - TOTAL_TYPES];
+            double value_local = 0.0;
+            if (pp->collect(pp->arg, &value_local) == 0) {
+                epicsMutexLock(scan_mutex);
+                pp->value = value_local;
+                epicsMutexUnlock(scan_mutex);
+            }
+        }
         break;
     }
+    epicsMutexUnlock(collect_mutex);
+    if (nDerived) derived_update(type);
+    if (nBursts) burst_check(type);
+    runtime = devIocStatsClock() - start;
+    cputime = devIocStatsThreadCpuTime() - cpuStart;
+    epicsMutexLock(scan_mutex);
+    timing_add(&scan[type].runtime, runtime);
+    timing_add(&scan[type].cputime, cputime);
+    epicsMutexUnlock(scan_mutex);
+
+    if (shmPublish) shm_publish();
     scanIoRequest(scan[type].ioscan);
     if(scan[type].on)
-		epicsTimerStartDelay(scan[type].wd, scan[type].rate_sec);
+		scan_start(type);
 }
 
 /* -------------------------------------------------------------------- */
@@ -383,23 +985,45 @@ static long ai_init(int pass)
     if (pass) return 0;
 
     /* Create timers */
-    for (i = 0; i < TOTAL_TYPES; i++) {
+    for (i = 0; i < TOTAL_TYPES + nProviders; i++) {
         scanIoInit(&scan[i].ioscan);
         scan[i].wd = wdogCreate(scan_time, i);
         scan[i].total = 0;
         scan[i].on = 0;
-        scan[i].rate_sec = parmTypes[i].scan_rate;
+        if (i < TOTAL_TYPES)
+            scan[i].rate_sec = parmTypes[i].scan_rate;
+        scan[i].period = scan[i].rate_sec;
     }
 
+    /* Hash the parm names for ai_init_record */
+    gphInitPvt((void *)&parmHash, 256);
+    for (i = 0; statsGetParms[i].name; i++)
+        parm_hash_add(statsGetParms[i].name, statsGetParms, &statsGetParms[i]);
+    for (i = 0; i < nProviders; i++)
+        parm_hash_add(providers[i].name, providers, &providers[i]);
+
     /* Init OSD stuff */
     scan_mutex = epicsMutexMustCreate();
+    collect_mutex = epicsMutexMustCreate();
     devIocStatsInitCpuUsage();
     devIocStatsInitCpuUtilization(&loadinfo);
+    devIocStatsInitSysLoad();
     devIocStatsInitFDUsage();
+    devIocStatsInitLimits();
+    devIocStatsInitRtInfo();
+    for (i = 0; i < LEAK_TYPES; i++) {
+        devIocStatsTrendInit(&leak[i].trend, devIocStatsTrendHours * 3600.0);
+        leak[i].hoursLeft = TREND_NEVER;
+    }
     devIocStatsInitMemUsage();
     devIocStatsInitWorkspaceUsage();
     devIocStatsInitSuspTasks();
+    devIocStatsInitStalls();
     devIocStatsInitIFErrors();
+    devIocStatsInitIOUsage();
+    devIocStatsInitTopProcs();
+    if (devIocStatsShm)
+        shmPublish = (devIocStatsInitShm() == 0);
     /* Get initial values of a few things that don't change much */
     devIocStatsGetClusterInfo(SYS_POOL, &clustinfo[SYS_POOL]);
     devIocStatsGetClusterInfo(DATA_POOL, &clustinfo[DATA_POOL]);
@@ -408,6 +1032,12 @@ static long ai_init(int pass)
     devIocStatsGetCpuUtilization(&loadinfo);
     devIocStatsGetIFErrors(&iferrors);
     devIocStatsGetFDUsage(&fdusage);
+    aiInitDone = 1;
+
+    for (i = 0; i < nBursts; i++)
+        if (!(bursts[i].pvt = parm_pvt(bursts[i].parm)))
+            errlogPrintf("iocStatsBurst: unknown parm %s\n", bursts[i].parm);
+    if (timerProbePeriod > 0) timer_probe_start();
 
     /* Count EPICS records */
     if (pdbbase) {
@@ -463,9 +1093,259 @@ static long ai_clusts_init_record(aiRecord *pr)
 	return 0;
 }
 
+/* Timing parms: <collector>_scan_time|cpu|late[_mean|_max],
+   <dset>_read_time[_mean|_max], timer_probe_late[_mean|_max] */
+static pvtArea *timing_parm(const char *parm)
+{
+	char name[PROVIDER_NAME_SIZE + 24];
+	const char *base;
+	int type, dev, stat, len;
+	pvtArea *pvt;
+
+	for (stat = STAT_LAST; stat <= STAT_MAX; stat++) {
+		for (type = 0; type < TOTAL_TYPES + nProviders; type++) {
+			if (!(base = collector_name(type, &len))) continue;
+			sprintf(name, "%.*s_scan_time%s", len, base, statSuffix[stat]);
+			if (strcmp(parm, name) == 0) break;
+			sprintf(name, "%.*s_scan_cpu%s", len, base, statSuffix[stat]);
+			if (strcmp(parm, name) == 0) break;
+			sprintf(name, "%.*s_scan_late%s", len, base, statSuffix[stat]);
+			if (strcmp(parm, name) == 0) break;
+		}
+		if (type < TOTAL_TYPES + nProviders) {
+			pvt = (pvtArea*)malloc(sizeof(pvtArea));
+			pvt->index = type;
+			pvt->type = type;
+			pvt->timing = strstr(name, "_scan_cpu") ? TIMING_CPU :
+			              strstr(name, "_scan_late") ? TIMING_LATE : TIMING_RUN;
+			pvt->stat = stat;
+			return pvt;
+		}
+		sprintf(name, "timer_probe_late%s", statSuffix[stat]);
+		if (strcmp(parm, name) == 0) {
+			pvt = (pvtArea*)malloc(sizeof(pvtArea));
+			pvt->index = 0;
+			pvt->type = LOAD_TYPE;
+			pvt->timing = TIMING_PROBE;
+			pvt->stat = stat;
+			return pvt;
+		}
+		for (dev = 0; dev < READ_TYPES; dev++) {
+			sprintf(name, "%s_read_time%s", readNames[dev], statSuffix[stat]);
+			if (strcmp(parm, name) == 0) {
+				pvt = (pvtArea*)malloc(sizeof(pvtArea));
+				pvt->index = dev;
+				pvt->type = LOAD_TYPE;
+				pvt->timing = TIMING_READ;
+				pvt->stat = stat;
+				return pvt;
+			}
+		}
+	}
+	return NULL;
+}
+
+/* Find a parm of statsGetParms or a provider */
+static int parm_lookup(const char *parm, int *ptype, int *pindex)
+{
+	GPHENTRY *pgph;
+
+	/* "probe <name>" for file probes (devIocStatsProbe.c) */
+	if(strncmp(parm,"probe ",6)==0)
+		for(parm+=6; *parm==' '; parm++);
+	if((pgph=gphFind(parmHash,parm,statsGetParms)))
+	{
+		validGetParms *pparm=(validGetParms*)pgph->userPvt;
+		*pindex=pparm-statsGetParms;
+		*ptype=pparm->type;
+		return 0;
+	}
+	if((pgph=gphFind(parmHash,parm,providers)))
+	{
+		*pindex=(providerInfo*)pgph->userPvt-providers;
+		*ptype=TOTAL_TYPES+*pindex;
+		return 0;
+	}
+	return -1;
+}
+
+/* "<parm>:rate", ":delta", ":ewma(<tau>)", ":pct_of(<parm>)", ":hwm",
+   ":lwm", ":hwm_time" or ":lwm_time" */
+static pvtArea *derived_parm(const char *parm)
+{
+	char base[PROVIDER_NAME_SIZE + 8], ref[PROVIDER_NAME_SIZE + 8];
+	const char *suffix = strrchr(parm, ':');
+	derivedInfo d, *pd;
+	GPHENTRY *pgph;
+	pvtArea *pvt;
+	char *key;
+	int n, stamp = 0;
+
+	if (!suffix || suffix - parm >= (int)sizeof(base)) return NULL;
+	memset(&d, 0, sizeof(d));
+	sprintf(base, "%.*s", (int)(suffix - parm), parm);
+	if (parm_lookup(base, &d.type, &d.index)) return NULL;
+	suffix++;
+
+	n = 0;
+	if (strcmp(suffix, "rate") == 0)
+		d.kind = DERIVED_RATE;
+	else if (strcmp(suffix, "delta") == 0)
+		d.kind = DERIVED_DELTA;
+	else if (sscanf(suffix, "ewma(%lf)%n", &d.tau, &n) == 1 && n &&
+		 !suffix[n] && d.tau > 0)
+		d.kind = DERIVED_EWMA;
+	else if (sscanf(suffix, "pct_of(%47[^)])%n", ref, &n) == 1 && n &&
+		 !suffix[n] && parm_lookup(ref, &d.refType, &d.refIndex) == 0)
+		d.kind = DERIVED_PCT_OF;
+	else if (strncmp(suffix, "hwm", 3) == 0 || strncmp(suffix, "lwm", 3) == 0) {
+		d.kind = suffix[0] == 'h' ? DERIVED_HWM : DERIVED_LWM;
+		if (strcmp(suffix + 3, "_time") == 0) stamp = 1;
+		else if (suffix[3]) return NULL;
+	}
+	else
+		return NULL;
+
+	/* <parm>:hwm_time shares the entry of <parm>:hwm */
+	key = epicsStrDup(parm);
+	if (stamp) key[strlen(key) - 5] = '\0';
+	epicsMutexLock(scan_mutex);
+	if ((pgph = gphFind(parmHash, key, derived))) {
+		pd = (derivedInfo*)pgph->userPvt;
+		free(key);
+	} else if (nDerived < MAX_DERIVED) {
+		pd = &derived[nDerived];
+		*pd = d;
+		pd->parm = key;
+		parm_hash_add(pd->parm, derived, pd);
+		nDerived++;
+	} else {
+		pd = NULL;
+		free(key);
+	}
+	epicsMutexUnlock(scan_mutex);
+	if (!pd) {
+		errlogPrintf("devAiStats: more than %d derived parms\n", MAX_DERIVED);
+		return NULL;
+	}
+
+	pvt = (pvtArea*)malloc(sizeof(pvtArea));
+	pvt->index = pd - derived;
+	pvt->type = pd->type;
+	pvt->timing = TIMING_DERIVED;
+	pvt->stat = stamp;
+	return pvt;
+}
+
+/* Seed a water mark with the value autosave restored (pass 0) into VAL.
+ * A restored VAL clears UDF, a mark of 0 is a valid value (e.g. the :lwm
+ * of a free resource); a _time of 0 is never set and is skipped. */
+static void derived_restore(pvtArea *pvt, double val, int restored)
+{
+	derivedInfo *pd = &derived[pvt->index];
+
+	if (!restored || (pd->kind != DERIVED_HWM && pd->kind != DERIVED_LWM))
+		return;
+	epicsMutexLock(scan_mutex);
+	if (pvt->stat) {
+		val -= POSIX_TIME_AT_EPICS_EPOCH;
+		if (val > 0) {
+			pd->when.secPastEpoch = (epicsUInt32)val;
+			pd->when.nsec = (epicsUInt32)((val - pd->when.secPastEpoch) * 1e9);
+		}
+	} else {
+		pd->value = val;
+		pd->valid = 1;
+		if (!pd->when.secPastEpoch) epicsTimeGetCurrent(&pd->when);
+	}
+	epicsMutexUnlock(scan_mutex);
+}
+
+void *devIocStatsFindParm(const char *parm)
+{
+	return aiInitDone ? (void*)parm_pvt(parm) : NULL;
+}
+
+double devIocStatsParmValue(void *parm)
+{
+	double val;
+
+	epicsMutexLock(scan_mutex);
+	val = pvt_value((pvtArea*)parm);
+	epicsMutexUnlock(scan_mutex);
+	return val;
+}
+
+/* Restart all high and low water marks at the current values */
+void devIocStatsResetMarks(void)
+{
+	int reset[MAX_TYPES];
+	derivedInfo *pd;
+	int i;
+
+	memset(reset, 0, sizeof(reset));
+	epicsMutexLock(scan_mutex);
+	for (i = 0; i < nDerived; i++) {
+		pd = &derived[i];
+		if (pd->kind != DERIVED_HWM && pd->kind != DERIVED_LWM) continue;
+		pd->value = parm_value(pd->type, pd->index);
+		epicsTimeGetCurrent(&pd->when);
+		pd->valid = 1;
+		reset[pd->type] = 1;
+	}
+	epicsMutexUnlock(scan_mutex);
+	for (i = 0; i < MAX_TYPES; i++)
+		if (reset[i]) scanIoRequest(scan[i].ioscan);
+}
+
+/* "<coll>_scan_period", the effective period of a collector */
+static pvtArea *period_parm(const char *parm)
+{
+	char name[PROVIDER_NAME_SIZE + 16];
+	const char *base;
+	int type, len;
+	pvtArea *pvt;
+
+	for (type = 0; type < TOTAL_TYPES + nProviders; type++) {
+		if (!(base = collector_name(type, &len))) continue;
+		sprintf(name, "%.*s_scan_period", len, base);
+		if (strcmp(parm, name) == 0) {
+			pvt = (pvtArea*)malloc(sizeof(pvtArea));
+			pvt->index = type;
+			pvt->type = type;
+			pvt->timing = TIMING_PERIOD;
+			pvt->stat = 0;
+			return pvt;
+		}
+	}
+	return NULL;
+}
+
+/* Private part for any ai parm, NULL if unknown */
+static pvtArea *parm_pvt(const char *parm)
+{
+	pvtArea	*pvt = NULL;
+	int	type, index;
+
+	if(parm_lookup(parm,&type,&index)==0)
+	{
+		pvt=(pvtArea*)malloc(sizeof(pvtArea));
+		pvt->index=index;
+		pvt->type=type;
+		pvt->timing=TIMING_NONE;
+		pvt->stat=0;
+	}
+	if(pvt==NULL)
+		pvt=timing_parm(parm);
+	if(pvt==NULL)
+		pvt=period_parm(parm);
+	if(pvt==NULL)
+		pvt=derived_parm(parm);
+	return pvt;
+}
+
 static long ai_init_record(aiRecord* pr)
 {
-	int		i;
 	char	*parm;
 	pvtArea	*pvt = NULL;
 
@@ -476,16 +1356,10 @@ static long ai_init_record(aiRecord* pr)
 		return S_db_badField;
 	}
 	parm = pr->inp.value.instio.string;
-	for(i=0;statsGetParms[i].name && pvt==NULL;i++)
-	{
-		if(strcmp(parm,statsGetParms[i].name)==0)
-		{
-			pvt=(pvtArea*)malloc(sizeof(pvtArea));
-			pvt->index=i;
-			pvt->type=statsGetParms[i].type;
-		}
-	}
-	
+	pvt=parm_pvt(parm);
+	if(pvt && pvt->timing==TIMING_DERIVED)
+		derived_restore(pvt,pr->val,!pr->udf);
+
 	if(pvt==NULL)
 	{
 		recGblRecordError(S_db_badField,(void*)pr,
@@ -503,6 +1377,7 @@ static long ao_init_record(aoRecord* pr)
 {
 	int		type;
 	char	*parm;
+	char	name[PROVIDER_NAME_SIZE + 12];
 	pvtArea	*pvt = NULL;
 
 	if(pr->out.type!=INST_IO)
@@ -512,9 +1387,16 @@ static long ao_init_record(aoRecord* pr)
 		return S_db_badField;
 	}
 	parm = pr->out.value.instio.string;
-	for(type=0; type<TOTAL_TYPES; type++)
+	for(type=0; type<TOTAL_TYPES+nProviders && pvt==NULL; type++)
 	{
-		if(parmTypes[type].name && strcmp(parm,parmTypes[type].name)==0)
+		if(type<TOTAL_TYPES)
+		{
+			if(!parmTypes[type].name) continue;
+			strcpy(name,parmTypes[type].name);
+		}
+		else
+			sprintf(name,"%s_scan_rate",providers[type-TOTAL_TYPES].name);
+		if(strcmp(parm,name)==0)
 		{
 			pvt=(pvtArea*)malloc(sizeof(pvtArea));
 			pvt->index=type;
@@ -530,7 +1412,7 @@ static long ao_init_record(aoRecord* pr)
 
 	/* Initialize value with default if not set in db */
 	if (!pr->val)
-		pr->val=parmTypes[pvt->type].scan_rate;
+		pr->val=scan[pvt->type].rate_sec;
 
 	/* Make sure record processing routine does not perform any conversion*/
 	pr->linr=menuConvertNO_CONVERSION;
@@ -538,31 +1420,47 @@ static long ao_init_record(aoRecord* pr)
 	return 2;
 }
 
-static long ai_ioint_info(int cmd,aiRecord* pr,IOSCANPVT* iopvt)
+/* I/O Intr hookup, also used by the waveform support */
+long devIocStatsIointInfo(int type, int cmd, IOSCANPVT* iopvt)
 {
-	pvtArea* pvt=(pvtArea*)pr->dpvt;
-
-	if (!pvt) return S_dev_badInpType;
+	if (type < 0 || type >= TOTAL_TYPES + nProviders) return S_dev_badInpType;
 
 	if(cmd==0) /* added */
 	{
-		if(scan[pvt->type].total++ == 0)
+		if(scan[type].total++ == 0)
 		{
 			/* start a watchdog */
-			epicsTimerStartDelay(scan[pvt->type].wd, scan[pvt->type].rate_sec);
-			scan[pvt->type].on=1;
+			scan_start(type);
+			scan[type].on=1;
 		}
 	}
 	else /* deleted */
 	{
-		if(--scan[pvt->type].total == 0)
-			scan[pvt->type].on=0; /* stop the watchdog */
+		if(--scan[type].total == 0)
+			scan[type].on=0; /* stop the watchdog */
 	}
 
-	*iopvt=scan[pvt->type].ioscan;
+	*iopvt=scan[type].ioscan;
 	return 0;
 }
 
+static long ai_ioint_info(int cmd,aiRecord* pr,IOSCANPVT* iopvt)
+{
+	pvtArea* pvt=(pvtArea*)pr->dpvt;
+	derivedInfo *pd;
+	IOSCANPVT refscan;
+
+	if (!pvt) return S_dev_badInpType;
+
+	/* pct_of(<parm>) of another collector needs that one running too */
+	if (pvt->timing == TIMING_DERIVED) {
+		pd = &derived[pvt->index];
+		if (pd->kind == DERIVED_PCT_OF && pd->refType != pvt->type)
+			devIocStatsIointInfo(pd->refType, cmd, &refscan);
+	}
+	return devIocStatsIointInfo(pvt->type, cmd, iopvt);
+}
+
 static long ao_write(aoRecord* pr)
 {
 	pvtArea	*pvt=(pvtArea*)pr->dpvt;
@@ -580,6 +1478,53 @@ static long ao_write(aoRecord* pr)
 	return 0;
 }
 
+static char *boParms[] = { "hwm_reset", "recorder_dump", "latency_reset", NULL };
+#define BO_HWM_RESET		0
+#define BO_RECORDER_DUMP	1
+#define BO_LATENCY_RESET	2
+
+static long bo_init_record(boRecord* pr)
+{
+	pvtArea	*pvt;
+	int	i;
+
+	if(pr->out.type!=INST_IO)
+	{
+		recGblRecordError(S_db_badField,(void*)pr,
+			"devBoStats (init_record) Illegal OUT field");
+		return S_db_badField;
+	}
+	for(i=0; boParms[i]; i++)
+		if(strcmp(pr->out.value.instio.string,boParms[i])==0) break;
+	if(!boParms[i])
+	{
+		recGblRecordError(S_db_badField,(void*)pr,
+			"devBoStats (init_record) Illegal OUT parm field");
+		return S_db_badField;
+	}
+	pvt=(pvtArea*)malloc(sizeof(pvtArea));
+	pvt->index=i;
+	pvt->type=STATIC_TYPE;
+	pvt->timing=TIMING_NONE;
+	pvt->stat=0;
+	pr->dpvt=pvt;
+	return 2; /* don't convert */
+}
+
+static long bo_write(boRecord* pr)
+{
+	pvtArea	*pvt=(pvtArea*)pr->dpvt;
+
+	if (!pvt) return S_dev_badOutType;
+	if (!pr->val) return 0;
+	switch (pvt->index) {
+	case BO_HWM_RESET:	devIocStatsResetMarks(); break;
+	case BO_RECORDER_DUMP:	devIocStatsRecorderRequest("PV write"); break;
+	case BO_LATENCY_RESET:	devIocStatsResetLatency(); break;
+	}
+	return 0;
+}
+
 /* Cluster info read - returning value from global array */
 static long ai_clusts_read(aiRecord* prec)
 {
@@ -599,21 +1544,421 @@ static long ai_clusts_read(aiRecord* prec)
 }
 
 /* Generic read - calling function from table */
+/* Value of any ai parm, call with scan_mutex held */
+static double pvt_value(const pvtArea *pvt)
+{
+    switch (pvt->timing) {
+    case TIMING_RUN:    return timing_get(&scan[pvt->index].runtime, pvt->stat);
+    case TIMING_CPU:    return timing_get(&scan[pvt->index].cputime, pvt->stat);
+    case TIMING_READ:   return timing_get(&readtime[pvt->index], pvt->stat);
+    case TIMING_PERIOD: return scan[pvt->index].period;
+    case TIMING_LATE:   return timing_get(&scan[pvt->index].late, pvt->stat);
+    case TIMING_PROBE:  return timing_get(&timerProbeLate, pvt->stat);
+    case TIMING_DERIVED:
+        if (pvt->stat)
+            return derived[pvt->index].when.secPastEpoch + POSIX_TIME_AT_EPICS_EPOCH
+                   + derived[pvt->index].when.nsec / 1e9;
+        return derived[pvt->index].value;
+    default:            return parm_value(pvt->type, pvt->index);
+    }
+}
+
 static long ai_read(aiRecord* pr)
 {
     double val;
+    double start = devIocStatsClock();
     pvtArea* pvt=(pvtArea*)pr->dpvt;
 
     if (!pvt) return S_dev_badInpType;
 
     epicsMutexLock(scan_mutex);
-    statsGetParms[pvt->index].func(&val);
+    val = pvt_value(pvt);
+    /* TSE -2: time stamp of the water mark */
+    if (pvt->timing == TIMING_DERIVED && pr->tse == epicsTimeEventDeviceTime)
+        pr->time = derived[pvt->index].when;
     epicsMutexUnlock(scan_mutex);
     pr->val = val;
     pr->udf = 0;
+    devIocStatsReadTime(READ_AI, start);
     return 2; /* don't convert */
 }
+
+/* Add the time since start to the read statistics of a dset */
+void devIocStatsReadTime(int dev, double start)
+{
+    double elapsed = devIocStatsClock() - start;
+
+    epicsMutexLock(scan_mutex);
+    timing_add(&readtime[dev], elapsed);
+    epicsMutexUnlock(scan_mutex);
+}
+
+void devIocStatsShowRead(int dev)
+{
+    timingInfo t;
+
+    epicsMutexLock(scan_mutex);
+    t = readtime[dev];
+    epicsMutexUnlock(scan_mutex);
+    printf("  %-8s read %10lu %10.1f %10.1f %10.1f us\n", readNames[dev],
+           t.count, t.last * 1e6, timing_get(&t, STAT_MEAN) * 1e6, t.max * 1e6);
+}
+
+void devIocStatsShow(int level)
+{
+    static scanInfo s[MAX_TYPES];
+    stallInfo stalls;
+    timingInfo probe;
+    const char *name;
+    int type, dev, len, ntypes, i;
+
+    epicsMutexLock(scan_mutex);
+    ntypes = TOTAL_TYPES + nProviders;
+    for (type = 0; type < ntypes; type++) s[type] = scan[type];
+    probe = timerProbeLate;
+    epicsMutexUnlock(scan_mutex);
+
+    printf("devIocStats collectors (ms):\n");
+    printf("  %-12s %6s %3s %8s %8s %8s %8s %8s %8s %8s %8s %8s\n",
+           "collector", "period", "on", "runs", "last", "mean", "max",
+           "cpu last", "cpu mean", "cpu max", "late", "late max");
+    for (type = 0; type < ntypes; type++) {
+        if (!(name = collector_name(type, &len))) continue;
+        printf("  %-12.*s %6.1f %3s %8lu %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f\n",
+               len, name,
+               s[type].period, s[type].on ? "yes" : "no", s[type].runtime.count,
+               s[type].runtime.last * 1e3,
+               timing_get(&s[type].runtime, STAT_MEAN) * 1e3,
+               s[type].runtime.max * 1e3, s[type].cputime.last * 1e3,
+               timing_get(&s[type].cputime, STAT_MEAN) * 1e3,
+               s[type].cputime.max * 1e3, s[type].late.last * 1e3,
+               s[type].late.max * 1e3);
+    }
+    if (timerProbePeriod > 0)
+        printf("  timer probe (priority %d, every %g s): %lu runs, late %.3f "
+               "mean %.3f max %.3f\n", timerProbePriority, timerProbePeriod,
+               probe.count, probe.last * 1e3, timing_get(&probe, STAT_MEAN) * 1e3,
+               probe.max * 1e3);
+    devIocStatsReadStalls(&stalls);
+    if (stalls.n)
+        printf("devIocStats stalled threads (%d, > %g s):\n", stalls.n,
+               devIocStatsStallSeconds);
+    for (i = 0; i < stalls.nList; i++)
+        printf("  %-16s %c %-24s %8.0f s\n", stalls.list[i].name,
+               stalls.list[i].state, stalls.list[i].wchan, stalls.list[i].seconds);
+    if (level < 1) return;
+    for (i = 0; i < nBursts; i++)
+        printf("  burst: %s %s %g -> every %g s, hold %g s%s\n", bursts[i].parm,
+               bursts[i].above ? ">" : "<", bursts[i].threshold,
+               bursts[i].period, bursts[i].hold, bursts[i].pvt ? "" : " (unknown)");
+    printf("devIocStats device support reads:\n");
+    printf("  %-13s %10s %10s %10s %10s\n", "", "count", "last", "mean", "max");
+    for (dev = 0; dev < READ_TYPES; dev++)
+        devIocStatsShowRead(dev);
+}
+
+static long ai_report(int level)
+{
+    devIocStatsShow(0);
+    devIocStatsShowRead(READ_AI);
+    return 0;
+}
+
+static const iocshArg iocStatsShowArg0 = { "level", iocshArgInt };
+static const iocshArg * const iocStatsShowArgs[] = { &iocStatsShowArg0 };
+static const iocshFuncDef iocStatsShowDef = { "iocStatsShow", 1, iocStatsShowArgs };
+static void iocStatsShowCall(const iocshArgBuf *args)
+{
+    devIocStatsShow(args[0].ival);
+}
+
+/* Run the collector of parm every period seconds while parm is above
+   (op ">") or below ("<") the threshold, and for hold seconds after */
+int devIocStatsAddBurst(const char *parm, const char *op, double threshold,
+                        double period, double hold)
+{
+    burstInfo *pb;
+    pvtArea *pvt = NULL;
+
+    if (!parm || !*parm || strlen(parm) >= BURST_PARM_SIZE || !op ||
+        (strcmp(op, ">") && strcmp(op, "<")) || period <= 0) {
+        errlogPrintf("Usage: iocStatsBurst <parm> <'>'|'<'> <threshold> "
+                     "<period> <hold>\n");
+        return -1;
+    }
+    if (nBursts == MAX_BURST) {
+        errlogPrintf("iocStatsBurst: more than %d policies\n", MAX_BURST);
+        return -1;
+    }
+    if (aiInitDone && !(pvt = parm_pvt(parm))) {
+        errlogPrintf("iocStatsBurst: unknown parm %s\n", parm);
+        return -1;
+    }
+    pb = &bursts[nBursts];
+    strcpy(pb->parm, parm);
+    pb->above = (op[0] == '>');
+    pb->threshold = threshold;
+    pb->period = period;
+    pb->hold = hold > 0 ? hold : 0;
+    pb->pvt = pvt;
+    if (aiInitDone) epicsMutexLock(scan_mutex);
+    nBursts++;
+    if (aiInitDone) epicsMutexUnlock(scan_mutex);
+    return 0;
+}
+
+static const iocshArg iocStatsBurstArg0 = { "parm", iocshArgString };
+static const iocshArg iocStatsBurstArg1 = { "'>'|'<'", iocshArgString };
+static const iocshArg iocStatsBurstArg2 = { "threshold", iocshArgDouble };
+static const iocshArg iocStatsBurstArg3 = { "period", iocshArgDouble };
+static const iocshArg iocStatsBurstArg4 = { "hold", iocshArgDouble };
+static const iocshArg * const iocStatsBurstArgs[] = {
+    &iocStatsBurstArg0, &iocStatsBurstArg1, &iocStatsBurstArg2,
+    &iocStatsBurstArg3, &iocStatsBurstArg4
+};
+static const iocshFuncDef iocStatsBurstDef = { "iocStatsBurst", 5, iocStatsBurstArgs };
+static void iocStatsBurstCall(const iocshArgBuf *args)
+{
+    devIocStatsAddBurst(args[0].sval, args[1].sval, args[2].dval,
+                        args[3].dval, args[4].dval);
+}
+
+/* Number of reasons the IOC isn't real-time, printed if verbose */
+static int rt_problems(const rtInfo *pr, int verbose)
+{
+    int n = 0;
+
+    if (pr->threads == 0) return 0;	/* no information */
+    if (pr->rtThreads == 0) {
+        n++;
+        if (verbose) printf("  problem: no thread has a real-time policy\n");
+    }
+    if (pr->memLocked < 0.9 * pr->memRss) {
+        n++;
+        if (verbose) printf("  problem: memory is not locked (mlockall)\n");
+    }
+    if (!pr->preemptRt) {
+        n++;
+        if (verbose) printf("  problem: kernel is not PREEMPT_RT\n");
+    }
+    return n;
+}
+
+static void devIocStatsRtShow(int level)
+{
+    rtInfo r;
+    rtThread *threads;
+    int i, n;
+
+    if (devIocStatsGetRtInfo(&r) != 0) {
+        printf("iocStatsRtShow: not available on this OS\n");
+        return;
+    }
+    printf("devIocStats real-time readiness%s:\n",
+           devIocStatsRealTime ? "" : " (devIocStatsRealTime not set)");
+    printf("  %d of %d threads real-time, %s kernel\n", r.rtThreads, r.threads,
+           r.preemptRt ? "PREEMPT_RT" : "non-RT");
+    printf("  locked %.0f of %.0f kB RSS, RLIMIT_MEMLOCK %.0f, RLIMIT_RTPRIO %.0f"
+           " (-1 = unlimited)\n", r.memLocked / 1024, r.memRss / 1024,
+           r.memlockLimit, r.rtprioLimit);
+    if (!rt_problems(&r, 1)) printf("  no problems\n");
+    if (level < 1 || r.threads == 0) return;
+
+    threads = calloc(r.threads + 16, sizeof(rtThread));
+    if (!threads) return;
+    n = devIocStatsGetRtThreads(threads, r.threads + 16);
+    printf("  %-7s %-16s %-8s %4s %-16s %12s\n",
+           "tid", "name", "policy", "prio", "affinity", "slack (ns)");
+    for (i = 0; i < n; i++)
+        printf("  %-7d %-16s %-8s %4d %-16s %12.0f\n", threads[i].tid,
+               threads[i].name, threads[i].policyName, threads[i].priority,
+               threads[i].affinity, threads[i].timerSlack);
+    free(threads);
+}
+
+static const iocshArg iocStatsRtShowArg0 = { "level", iocshArgInt };
+static const iocshArg * const iocStatsRtShowArgs[] = { &iocStatsRtShowArg0 };
+static const iocshFuncDef iocStatsRtShowDef = { "iocStatsRtShow", 1, iocStatsRtShowArgs };
+static void iocStatsRtShowCall(const iocshArgBuf *args)
+{
+    devIocStatsRtShow(args[0].ival);
+}
+
+/* Start the probe timer on the shared timer queue of an EPICS priority */
+int devIocStatsTimerProbe(double period, int priority)
+{
+	if (timerProbePeriod > 0) {
+		errlogPrintf("iocStatsTimerProbe: already running\n");
+		return -1;
+	}
+	if (priority <= 0 || priority > epicsThreadPriorityMax)
+		priority = epicsThreadPriorityScanLow;
+	timerProbePriority = priority;
+	timerProbePeriod = period > 0 ? period : 1.0;
+	if (aiInitDone) timer_probe_start();
+	return 0;
+}
+
+static const iocshArg iocStatsTimerProbeArg0 = { "period", iocshArgDouble };
+static const iocshArg iocStatsTimerProbeArg1 = { "priority", iocshArgInt };
+static const iocshArg * const iocStatsTimerProbeArgs[] = {
+	&iocStatsTimerProbeArg0, &iocStatsTimerProbeArg1
+};
+static const iocshFuncDef iocStatsTimerProbeDef = { "iocStatsTimerProbe", 2, iocStatsTimerProbeArgs };
+static void iocStatsTimerProbeCall(const iocshArgBuf *args)
+{
+	devIocStatsTimerProbe(args[0].dval, args[1].ival);
+}
+
+static const iocshFuncDef iocStatsResetMarksDef = { "iocStatsResetMarks", 0, NULL };
+static void iocStatsResetMarksCall(const iocshArgBuf *args)
+{
+    devIocStatsResetMarks();
+}
+
+static void devIocStatsRegister(void)
+{
+    iocshRegister(&iocStatsShowDef, iocStatsShowCall);
+    iocshRegister(&iocStatsResetMarksDef, iocStatsResetMarksCall);
+    iocshRegister(&iocStatsBurstDef, iocStatsBurstCall);
+    iocshRegister(&iocStatsRtShowDef, iocStatsRtShowCall);
+    iocshRegister(&iocStatsTimerProbeDef, iocStatsTimerProbeCall);
+}
+epicsExportRegistrar(devIocStatsRegister);
 
+/* Copy of all ai values, e.g. for the metrics exporter; returns the count.
+   Collectors of types without records are started by subscribing with
+   devIocStatsIointInfo(). */
+int devIocStatsReadAll(statsValue *pval, int max)
+{
+    int i, j;
+
+    epicsMutexLock(scan_mutex);
+    for (i = 0; statsGetParms[i].name && i < max; i++) {
+        pval[i].name = statsGetParms[i].name;
+        pval[i].type = statsGetParms[i].type;
+        statsGetParms[i].func(&pval[i].value);
+    }
+    for (j = 0; j < nProviders && i < max; j++, i++) {
+        pval[i].name = providers[j].name;
+        pval[i].type = TOTAL_TYPES + j;
+        pval[i].value = providers[j].value;
+    }
+    epicsMutexUnlock(scan_mutex);
+    return i;
+}
+
+/* Keep the collectors out of the OSD getters, for other callers of the
+   ones with state between calls (e.g. benchmarks); they wait meanwhile */
+void devIocStatsLockCollectors(void)
+{
+    if (collect_mutex) epicsMutexMustLock(collect_mutex);
+}
+
+void devIocStatsUnlockCollectors(void)
+{
+    if (collect_mutex) epicsMutexUnlock(collect_mutex);
+}
+
+/* Whether any collector is running (changing the procfs root or clock of
+   devIocStatsReplay.c is refused then) */
+int devIocStatsCollectorsRunning(void)
+{
+    int i;
+
+    for (i = 0; i < TOTAL_TYPES + nProviders; i++)
+        if (scan[i].on) return 1;
+    return 0;
+}
+
+/* Number of values devIocStatsReadAll() can return */
+int devIocStatsNumValues(void)
+{
+    int i;
+
+    for (i = 0; statsGetParms[i].name; i++) ;
+    return i + nProviders;
+}
+
+/* Number of collector types including the providers */
+int devIocStatsNumTypes(void)
+{
+    return TOTAL_TYPES + nProviders;
+}
+
+/* Add a statistic of another support module, collected every period
+   seconds by calling collect(arg, &value) from the devIocStats timer
+   thread; collect returns 0 if the value is valid.  Only before iocInit.
+   Returns 0 / -1. */
+int devIocStatsRegisterProvider(const char *name, devIocStatsCollectFunc collect,
+                                void *arg, double period)
+{
+    providerInfo *pp;
+    pvtArea *pvt;
+    int type, i;
+
+    if (!name || !*name || strlen(name) >= PROVIDER_NAME_SIZE || !collect ||
+        strpbrk(name, " :")) {
+        errlogPrintf("devIocStatsRegisterProvider: invalid name or function\n");
+        return -1;
+    }
+    for (i = 0; statsGetParms[i].name; i++)
+        if (strcmp(name, statsGetParms[i].name) == 0) break;
+    if (statsGetParms[i].name) {
+        errlogPrintf("devIocStatsRegisterProvider: %s is a built-in parm\n", name);
+        return -1;
+    }
+    /* "<coll>_scan_time", "timer_probe_late" etc. of the collectors */
+    if ((pvt = timing_parm(name)) || (pvt = period_parm(name))) {
+        free(pvt);
+        errlogPrintf("devIocStatsRegisterProvider: %s is a timing parm\n", name);
+        return -1;
+    }
+    /* ai_init has set up the collectors */
+    if (aiInitDone) {
+        errlogPrintf("devIocStatsRegisterProvider: %s: too late, register "
+                     "before iocInit\n", name);
+        return -1;
+    }
+
+    if (scan_mutex) epicsMutexLock(scan_mutex);
+    for (i = 0; i < nProviders; i++)
+        if (strcmp(name, providers[i].name) == 0) break;
+    if (i < nProviders || nProviders == MAX_PROVIDERS) {
+        if (scan_mutex) epicsMutexUnlock(scan_mutex);
+        errlogPrintf("devIocStatsRegisterProvider: %s %s\n", name,
+                     i < nProviders ? "already registered" : "- too many providers");
+        return -1;
+    }
+    pp = &providers[nProviders];
+    type = TOTAL_TYPES + nProviders;
+    strcpy(pp->name, name);
+    pp->collect = collect;
+    pp->arg = arg;
+    pp->value = 0.0;
+    scan[type].rate_sec = period > 0 ? period : 10.0;
+    scan[type].period = scan[type].rate_sec;
+    nProviders++;
+    if (scan_mutex) epicsMutexUnlock(scan_mutex);
+    return 0;
+}
+
+/* Copy of the top process lists for the waveform support */
+void devIocStatsReadTopProcs(topProcInfo *pval)
+{
+    epicsMutexLock(scan_mutex);
+    *pval = topprocs;
+    epicsMutexUnlock(scan_mutex);
+}
+
+/* Copy of the stalled thread list for the waveform support */
+void devIocStatsReadStalls(stallInfo *pval)
+{
+    epicsMutexLock(scan_mutex);
+    *pval = stallinfo;
+    epicsMutexUnlock(scan_mutex);
+}
+
 /* -------------------------------------------------------------------- */
 
 
@@ -681,10 +2026,42 @@ static void statsNoOfCpus(double* val)
 {
     *val = (double)loadinfo.noOfCpus;
 }
+static void statsIocRunqWait(double* val)
+{
+    *val = loadinfo.iocRunqWait;
+}
+static void statsLoadAvg1(double* val)
+{
+    *val = sysloadinfo.loadAvg[0];
+}
+static void statsLoadAvg5(double* val)
+{
+    *val = sysloadinfo.loadAvg[1];
+}
+static void statsLoadAvg15(double* val)
+{
+    *val = sysloadinfo.loadAvg[2];
+}
+static void statsRunnableTasks(double* val)
+{
+    *val = (double)sysloadinfo.runnable;
+}
+static void statsTotalTasks(double* val)
+{
+    *val = (double)sysloadinfo.total;
+}
+static void statsSysRunqWait(double* val)
+{
+    *val = sysloadinfo.runqWait;
+}
 static void statsSuspendedTasks(double *val)
 {
     *val = (double)susptasknumber;
 }
+static void statsStalledThreads(double *val)
+{
+    *val = (double)stallinfo.n;
+}
 static void statsFdUsage(double* val)
 {
     *val = (double)fdusage.used;
@@ -739,3 +2116,133 @@ static void statsPPID(double *val)
     *val = 0;
     devIocStatsGetPPID(val);
 }
+static void statsIOReadRate(double *val)
+{
+    *val = iousage.readBytes;
+}
+static void statsIOWriteRate(double *val)
+{
+    *val = iousage.writeBytes;
+}
+static void statsIOReadCalls(double *val)
+{
+    *val = iousage.readCalls;
+}
+static void statsIOWriteCalls(double *val)
+{
+    *val = iousage.writeCalls;
+}
+static void statsIODiskReadRate(double *val)
+{
+    *val = iousage.diskReadBytes;
+}
+static void statsIODiskWriteRate(double *val)
+{
+    *val = iousage.diskWriteBytes;
+}
+static void statsCpuDelay(double *val)
+{
+    *val = iousage.cpuDelay;
+}
+static void statsBlkIODelay(double *val)
+{
+    *val = iousage.blkioDelay;
+}
+static void statsSwapinDelay(double *val)
+{
+    *val = iousage.swapinDelay;
+}
+static void statsMemGrowth(double *val)
+{
+    *val = leak[LEAK_MEM].growth;
+}
+static void statsMemHoursLeft(double *val)
+{
+    *val = leak[LEAK_MEM].hoursLeft;
+}
+static void statsMemLimit(double *val)
+{
+    *val = memlimit;
+}
+static void statsFdGrowth(double *val)
+{
+    *val = leak[LEAK_FD].growth;
+}
+static void statsFdHoursLeft(double *val)
+{
+    *val = leak[LEAK_FD].hoursLeft;
+}
+static void statsThreads(double *val)
+{
+    *val = (double)limitinfo.threads;
+}
+static void statsThreadLimit(double *val)
+{
+    *val = limitinfo.threadLimit;
+}
+static void statsRtThreads(double *val)
+{
+    *val = (double)rtinfo.rtThreads;
+}
+static void statsMemLocked(double *val)
+{
+    *val = rtinfo.memLocked;
+}
+static void statsMemLockedPct(double *val)
+{
+    *val = rtinfo.memRss > 0 ? 100.0 * rtinfo.memLocked / rtinfo.memRss : 0.0;
+}
+static void statsRtprioLimit(double *val)
+{
+    *val = rtinfo.rtprioLimit;
+}
+static void statsMemlockLimit(double *val)
+{
+    *val = rtinfo.memlockLimit;
+}
+static void statsPreemptRt(double *val)
+{
+    *val = (double)rtinfo.preemptRt;
+}
+static void statsRtProblems(double *val)
+{
+    *val = devIocStatsRealTime ? (double)rt_problems(&rtinfo, 0) : 0.0;
+}
+static void statsLatencyMin(double *val)
+{
+    latencyInfo l;
+    devIocStatsReadLatency(&l);
+    *val = l.min * 1e6;
+}
+static void statsLatencyAvg(double *val)
+{
+    latencyInfo l;
+    devIocStatsReadLatency(&l);
+    *val = l.count > 0 ? l.sum / l.count * 1e6 : 0.0;
+}
+static void statsLatencyP99(double *val)
+{
+    latencyInfo l;
+    devIocStatsReadLatency(&l);
+    *val = devIocStatsLatencyPercentile(&l, 0.99);
+}
+static void statsLatencyMax(double *val)
+{
+    latencyInfo l;
+    devIocStatsReadLatency(&l);
+    *val = l.max * 1e6;
+}
+static void statsLatencySamples(double *val)
+{
+    latencyInfo l;
+    devIocStatsReadLatency(&l);
+    *val = l.count;
+}
+static void statsThreadGrowth(double *val)
+{
+    *val = leak[LEAK_THREAD].growth;
+}
+static void statsThreadHoursLeft(double *val)
+{
+    *val = leak[LEAK_THREAD].hoursLeft;
+}
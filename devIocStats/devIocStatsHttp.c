@@ -0,0 +1,388 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* devIocStatsHttp.c - OpenMetrics (Prometheus) exposition of the IOC statistics */
+
+/*
+ *  iocStatsHttpStart <port> <bindaddr>
+ *
+ *  starts a minimal HTTP server answering "GET /metrics" with all ai
+ *  parms of DTYP="IOC stats" in the OpenMetrics text format, e.g.
+ *
+ *	# TYPE iocstats_free_bytes gauge
+ *	iocstats_free_bytes{ioc="IOCTEST"} 1.2345e+09
+ *
+ *  and the lists behind the waveform and iocsh reports:
+ *
+ *	iocstats_wakeup_latency_seconds	histogram of the latency probe
+ *	iocstats_proc_cpu_percent{proc=,pid=}	top processes by CPU
+ *	iocstats_proc_rss_bytes{proc=,pid=}	top processes by memory
+ *	iocstats_stall_seconds{thread=,state=,wchan=,rank=}  stalled threads
+ *	iocstats_thread_realtime{thread=,tid=,policy=}	per IOC thread, also
+ *	iocstats_thread_rt_priority, iocstats_thread_timer_slack_seconds
+ *
+ *  The values are copied from the collectors' results, so serving a scrape
+ *  never processes records; only the per-thread data is read at the
+ *  scrape.  The collectors are started for the exporter even if no
+ *  records use them.  bindaddr defaults to 127.0.0.1, the ioc label is
+ *  the IOC environment variable.  Characters not allowed in metric names
+ *  (e.g. '-' and '.' in provider names) become '_'.
+ *
+ *  Test with:  curl http://localhost:<port>/metrics
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+#include <epicsThread.h>
+#include <epicsMutex.h>
+#include <osiSock.h>
+#include <dbAccess.h>
+#include <initHooks.h>
+#include <errlog.h>
+#include <iocsh.h>
+#include <epicsExport.h>
+
+#include "devIocStats.h"
+
+#define REQUEST_SIZE 2048
+#define LABEL_SIZE 256
+#define REQUEST_TIMEOUT 5	/* seconds */
+
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t size;
+} outBuf;
+
+static SOCKET listenSock = INVALID_SOCKET;
+static epicsMutexId subscribeLock = NULL;
+static int nSubscribed = 0;	/* collector types started so far */
+static const char *contentType =
+    "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+static void append (outBuf *pout, const char *fmt, ...)
+{
+    va_list args;
+    int n;
+
+    for (;;) {
+        va_start(args, fmt);
+        n = vsnprintf(pout->buf + pout->len, pout->size - pout->len, fmt, args);
+        va_end(args);
+        if (n >= 0 && (size_t)n < pout->size - pout->len) {
+            pout->len += n;
+            return;
+        }
+        {
+            char *p = realloc(pout->buf, pout->size * 2);
+            if (!p) return;
+            pout->buf = p;
+            pout->size *= 2;
+        }
+    }
+}
+
+/* Start all collectors, including the providers added since the last
+   call */
+static void subscribe (void)
+{
+    IOSCANPVT ioscan;
+    int type;
+
+    epicsMutexMustLock(subscribeLock);
+    for (type = nSubscribed; type < devIocStatsNumTypes(); type++)
+        if (type != STATIC_TYPE)
+            devIocStatsIointInfo(type, 0, &ioscan);
+    nSubscribed = type;
+    epicsMutexUnlock(subscribeLock);
+}
+
+/* OpenMetrics names are [a-zA-Z_:][a-zA-Z0-9_:]*, the prefix takes care
+   of the first character; ':' is left to recording rules */
+static void metricName (char *buf, size_t size, const char *name)
+{
+    size_t i;
+
+    for (i = 0; name[i] && i < size - 1; i++)
+        buf[i] = isalnum((unsigned char)name[i]) ? name[i] : '_';
+    buf[i] = '\0';
+}
+
+/* Label values escape '\\', '"' and newlines */
+static const char *labelValue (char *buf, size_t size, const char *value)
+{
+    size_t i = 0;
+
+    for (; value && *value && i < size - 2; value++) {
+        if (*value == '\\' || *value == '"') buf[i++] = '\\';
+        else if (*value == '\n') {
+            buf[i++] = '\\';
+            buf[i++] = 'n';
+            continue;
+        }
+        buf[i++] = *value;
+    }
+    buf[i] = '\0';
+    return buf;
+}
+
+/* Buckets of doubling width as in devIocStatsLatency.c, cumulative */
+static void renderLatency (outBuf *pout, const char *ioc)
+{
+    latencyInfo l;
+    double count = 0, edge = 2e-6;
+    int i;
+
+    devIocStatsReadLatency(&l);
+    if (l.period <= 0) return;		/* no probe running */
+    append(pout, "# TYPE iocstats_wakeup_latency_seconds histogram\n");
+    for (i = 0; i < LATENCY_BUCKETS - 1; i++, edge *= 2) {
+        count += l.hist[i];
+        append(pout, "iocstats_wakeup_latency_seconds_bucket{ioc=\"%s\",le=\"%g\"} %.17g\n",
+               ioc, edge, count);
+    }
+    append(pout, "iocstats_wakeup_latency_seconds_bucket{ioc=\"%s\",le=\"+Inf\"} %.17g\n",
+           ioc, l.count);
+    append(pout, "iocstats_wakeup_latency_seconds_count{ioc=\"%s\"} %.17g\n", ioc, l.count);
+    append(pout, "iocstats_wakeup_latency_seconds_sum{ioc=\"%s\"} %.17g\n", ioc, l.sum);
+}
+
+static void renderProcs (outBuf *pout, const char *ioc)
+{
+    topProcInfo top;
+    char proc[LABEL_SIZE];
+    int i;
+
+    devIocStatsReadTopProcs(&top);
+    append(pout, "# TYPE iocstats_proc_cpu_percent gauge\n");
+    for (i = 0; i < top.nCpu; i++)
+        append(pout, "iocstats_proc_cpu_percent{ioc=\"%s\",proc=\"%s\",pid=\"%d\"} %.17g\n",
+               ioc, labelValue(proc, sizeof(proc), top.byCpu[i].comm),
+               top.byCpu[i].pid, top.byCpu[i].cpuLoad);
+    append(pout, "# TYPE iocstats_proc_rss_bytes gauge\n");
+    for (i = 0; i < top.nMem; i++)
+        append(pout, "iocstats_proc_rss_bytes{ioc=\"%s\",proc=\"%s\",pid=\"%d\"} %.17g\n",
+               ioc, labelValue(proc, sizeof(proc), top.byMem[i].comm),
+               top.byMem[i].pid, top.byMem[i].rss);
+}
+
+/* Thread names need not be unique, rank is the place in the list */
+static void renderStalls (outBuf *pout, const char *ioc)
+{
+    stallInfo stalls;
+    char thread[LABEL_SIZE], wchan[LABEL_SIZE];
+    int i;
+
+    devIocStatsReadStalls(&stalls);
+    append(pout, "# TYPE iocstats_stall_seconds gauge\n");
+    for (i = 0; i < stalls.nList; i++)
+        append(pout, "iocstats_stall_seconds{ioc=\"%s\",thread=\"%s\",state=\"%c\","
+               "wchan=\"%s\",rank=\"%d\"} %.17g\n", ioc,
+               labelValue(thread, sizeof(thread), stalls.list[i].name),
+               stalls.list[i].state,
+               labelValue(wchan, sizeof(wchan), stalls.list[i].wchan),
+               i, stalls.list[i].seconds);
+}
+
+static void renderThreads (outBuf *pout, const char *ioc)
+{
+    static const char *family[] = {
+        "realtime", "rt_priority", "timer_slack_seconds"
+    };
+    rtInfo r;
+    rtThread *threads;
+    char thread[LABEL_SIZE];
+    double val;
+    int n, i, f;
+
+    if (devIocStatsGetRtInfo(&r) != 0 || r.threads == 0) return;
+    threads = calloc(r.threads + 16, sizeof(rtThread));
+    if (!threads) return;
+    n = devIocStatsGetRtThreads(threads, r.threads + 16);
+    for (f = 0; f < 3; f++) {
+        append(pout, "# TYPE iocstats_thread_%s gauge\n", family[f]);
+        for (i = 0; i < n; i++) {
+            val = f == 0 ? threads[i].realtime :
+                  f == 1 ? threads[i].priority : threads[i].timerSlack / 1e9;
+            if (f == 2 && threads[i].timerSlack < 0) continue;
+            append(pout, "iocstats_thread_%s{ioc=\"%s\",thread=\"%s\",tid=\"%d\","
+                   "policy=\"%s\"} %.17g\n", family[f], ioc,
+                   labelValue(thread, sizeof(thread), threads[i].name),
+                   threads[i].tid, threads[i].policyName, val);
+        }
+    }
+    free(threads);
+}
+
+static void render (outBuf *pout)
+{
+    statsValue *vals;
+    char name[PROVIDER_NAME_SIZE];
+    char ioc[LABEL_SIZE];
+    int n, i;
+
+    if (interruptAccept) subscribe();
+    labelValue(ioc, sizeof(ioc), getenv("IOC"));
+    n = devIocStatsNumValues();
+    vals = calloc(n ? n : 1, sizeof(statsValue));
+    if (!vals) return;
+    n = devIocStatsReadAll(vals, n);
+    for (i = 0; i < n; i++) {
+        metricName(name, sizeof(name), vals[i].name);
+        append(pout, "# TYPE iocstats_%s gauge\n", name);
+        append(pout, "iocstats_%s{ioc=\"%s\"} %.17g\n",
+               name, ioc, vals[i].value);
+    }
+    free(vals);
+    renderLatency(pout, ioc);
+    renderProcs(pout, ioc);
+    renderStalls(pout, ioc);
+    renderThreads(pout, ioc);
+    append(pout, "# EOF\n");
+}
+
+static void serve (SOCKET sock)
+{
+    char req[REQUEST_SIZE];
+    char header[256];
+    outBuf out;
+    int len = 0, n;
+#ifdef _WIN32
+    DWORD tmo = REQUEST_TIMEOUT * 1000;
+#else
+    struct timeval tmo = { REQUEST_TIMEOUT, 0 };
+#endif
+
+    /* Don't let a silent client block the server */
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (char *)&tmo, sizeof(tmo));
+
+    /* Read up to the end of the request header */
+    while (len < REQUEST_SIZE - 1) {
+        n = recv(sock, req + len, REQUEST_SIZE - 1 - len, 0);
+        if (n <= 0) break;
+        len += n;
+        req[len] = '\0';
+        if (strstr(req, "\r\n\r\n") || strstr(req, "\n\n")) break;
+    }
+    req[len] = '\0';
+
+    out.size = 8192;
+    out.len = 0;
+    out.buf = malloc(out.size);
+    if (!out.buf) return;
+    out.buf[0] = '\0';
+
+    if (strncmp(req, "GET /metrics ", 13) == 0 ||
+        strncmp(req, "GET /metrics?", 13) == 0) {
+        render(&out);
+        sprintf(header, "HTTP/1.0 200 OK\r\nContent-Type: %s\r\n"
+                "Content-Length: %lu\r\nConnection: close\r\n\r\n",
+                contentType, (unsigned long)out.len);
+    } else {
+        append(&out, "Not Found\n");
+        sprintf(header, "HTTP/1.0 404 Not Found\r\nContent-Type: text/plain\r\n"
+                "Content-Length: %lu\r\nConnection: close\r\n\r\n",
+                (unsigned long)out.len);
+    }
+    send(sock, header, strlen(header), 0);
+    send(sock, out.buf, out.len, 0);
+    free(out.buf);
+}
+
+static void httpTask (void *parm)
+{
+    osiSockAddr addr;
+    osiSocklen_t addrSize;
+    SOCKET sock;
+
+    for (;;) {
+        addrSize = sizeof(addr);
+        sock = epicsSocketAccept(listenSock, &addr.sa, &addrSize);
+        if (sock == INVALID_SOCKET) {
+            epicsThreadSleep(1.0);
+            continue;
+        }
+        serve(sock);
+        epicsSocketDestroy(sock);
+    }
+}
+
+static void httpInitHook (initHookState state)
+{
+    if (state == initHookAfterIocRunning) subscribe();
+}
+
+int devIocStatsHttpStart (int port, const char *bindaddr)
+{
+    struct sockaddr_in addr;
+    char buf[64];
+
+    if (listenSock != INVALID_SOCKET) {
+        errlogPrintf("iocStatsHttpStart: already running\n");
+        return -1;
+    }
+    if (port <= 0 || port > 65535) {
+        errlogPrintf("iocStatsHttpStart: invalid port %d\n", port);
+        return -1;
+    }
+    if (!bindaddr || !*bindaddr) bindaddr = "127.0.0.1";
+    if (aToIPAddr(bindaddr, (unsigned short)port, &addr)) {
+        errlogPrintf("iocStatsHttpStart: invalid address %s\n", bindaddr);
+        return -1;
+    }
+    if (osiSockAttach() == 0) return -1;
+    if (!subscribeLock) subscribeLock = epicsMutexMustCreate();
+
+    listenSock = epicsSocketCreate(AF_INET, SOCK_STREAM, 0);
+    if (listenSock == INVALID_SOCKET) {
+        epicsSocketConvertErrnoToString(buf, sizeof(buf));
+        errlogPrintf("iocStatsHttpStart: socket: %s\n", buf);
+        return -1;
+    }
+    epicsSocketEnableAddressReuseDuringTimeWaitState(listenSock);
+    if (bind(listenSock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(listenSock, 5) < 0) {
+        epicsSocketConvertErrnoToString(buf, sizeof(buf));
+        errlogPrintf("iocStatsHttpStart: %s:%d: %s\n", bindaddr, port, buf);
+        epicsSocketDestroy(listenSock);
+        listenSock = INVALID_SOCKET;
+        return -1;
+    }
+
+    /* The collectors exist once the device support is initialized */
+    if (interruptAccept) subscribe();
+    else initHookRegister(httpInitHook);
+
+    epicsThreadCreate("iocStatsHttp", epicsThreadPriorityLow,
+                      epicsThreadGetStackSize(epicsThreadStackMedium),
+                      httpTask, NULL);
+    return 0;
+}
+
+/* -------------------------------------------------------------------- */
+
+static const iocshArg iocStatsHttpStartArg0 = { "port", iocshArgInt };
+static const iocshArg iocStatsHttpStartArg1 = { "bindaddr", iocshArgString };
+static const iocshArg * const iocStatsHttpStartArgs[] = {
+    &iocStatsHttpStartArg0, &iocStatsHttpStartArg1
+};
+static const iocshFuncDef iocStatsHttpStartDef = {
+    "iocStatsHttpStart", 2, iocStatsHttpStartArgs
+};
+static void iocStatsHttpStartCall(const iocshArgBuf *args)
+{
+    devIocStatsHttpStart(args[0].ival, args[1].sval);
+}
+
+static void devIocStatsHttpRegister(void)
+{
+    iocshRegister(&iocStatsHttpStartDef, iocStatsHttpStartCall);
+}
+epicsExportRegistrar(devIocStatsHttpRegister);
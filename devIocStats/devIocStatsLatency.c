@@ -0,0 +1,181 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* devIocStatsLatency.c - Wakeup latency of a high priority thread
+ *                        (like cyclictest) */
+
+/*
+ *  iocStatsLatencyProbe <period> <priority>
+ *	starts a thread at EPICS priority <priority> (default
+ *	epicsThreadPriorityMax) that sleeps until absolute deadlines every
+ *	<period> seconds (default 0.001) on the monotonic clock and records
+ *	how late it wakes up.  Deadlines missed completely are skipped.
+ *  iocStatsLatencyReset
+ *	clears the statistics (also a bo record with OUT "@latency_reset")
+ *
+ *  The overshoot goes into a histogram with LATENCY_BUCKETS buckets of
+ *  doubling width: bucket 0 counts wakeups less than 2 us late, bucket i
+ *  those from 2^i to 2^(i+1) us, the last one all beyond.  The p99 is the
+ *  upper edge of the bucket it falls in (at most the maximum).
+ */
+
+#include <string.h>
+#include <stdio.h>
+
+#include <epicsThread.h>
+#include <epicsMutex.h>
+#include <errlog.h>
+#include <iocsh.h>
+#include <epicsExport.h>
+
+#include "devIocStats.h"
+
+static latencyInfo latency;
+static epicsMutexId latencyLock = NULL;
+static double latencyPeriod = 0.0;
+
+static void latencyClear (void)
+{
+    memset(&latency, 0, sizeof(latency));
+    latency.period = latencyPeriod;
+}
+
+void devIocStatsResetLatency (void)
+{
+    if (!latencyLock) return;
+    epicsMutexMustLock(latencyLock);
+    latencyClear();
+    epicsMutexUnlock(latencyLock);
+}
+
+void devIocStatsReadLatency (latencyInfo *pval)
+{
+    if (!latencyLock) {
+        memset(pval, 0, sizeof(latencyInfo));
+        return;
+    }
+    epicsMutexMustLock(latencyLock);
+    *pval = latency;
+    epicsMutexUnlock(latencyLock);
+}
+
+/* Upper edge (us) of the bucket holding the fraction p of the samples */
+double devIocStatsLatencyPercentile (const latencyInfo *pl, double p)
+{
+    double sum = 0.0, edge = 2.0;
+    int i;
+
+    if (pl->count == 0) return 0.0;
+    for (i = 0; i < LATENCY_BUCKETS - 1; i++, edge *= 2) {
+        sum += pl->hist[i];
+        if (sum >= p * pl->count) break;
+    }
+    return edge < pl->max * 1e6 ? edge : pl->max * 1e6;
+}
+
+static void latencyAdd (double late)
+{
+    double edge = 2e-6;
+    int i;
+
+    for (i = 0; i < LATENCY_BUCKETS - 1 && late >= edge; i++) edge *= 2;
+    epicsMutexMustLock(latencyLock);
+    if (latency.count == 0 || late < latency.min) latency.min = late;
+    if (late > latency.max) latency.max = late;
+    latency.sum += late;
+    latency.count++;
+    latency.hist[i]++;
+    epicsMutexUnlock(latencyLock);
+}
+
+static void latencyThread (void *arg)
+{
+    double next, now;
+
+    next = devIocStatsClock() + latencyPeriod;
+    for (;;) {
+        devIocStatsSleepUntil(next);
+        now = devIocStatsClock();
+        latencyAdd(now > next ? now - next : 0.0);
+        next += latencyPeriod;
+        while (next <= now) next += latencyPeriod;
+    }
+}
+
+static long iocStatsLatencyProbe (double period, int priority)
+{
+    if (latencyLock) {
+        errlogPrintf("iocStatsLatencyProbe: already running\n");
+        return -1;
+    }
+    if (period <= 0) period = 0.001;
+    if (priority <= 0 || priority > epicsThreadPriorityMax)
+        priority = epicsThreadPriorityMax;
+    latencyPeriod = period;
+    latencyLock = epicsMutexMustCreate();
+    latencyClear();
+    epicsThreadCreate("iocStatsLatency", priority,
+                      epicsThreadGetStackSize(epicsThreadStackSmall),
+                      latencyThread, NULL);
+    return 0;
+}
+
+static void iocStatsLatencyShow (void)
+{
+    latencyInfo l;
+    double edge = 2.0;
+    int i;
+
+    devIocStatsReadLatency(&l);
+    if (l.count == 0) {
+        printf("iocStatsLatency: no samples\n");
+        return;
+    }
+    printf("iocStatsLatency: %.0f samples every %g s, min %.1f avg %.1f "
+           "p99 %.0f max %.1f us\n", l.count, l.period, l.min * 1e6,
+           l.sum / l.count * 1e6, devIocStatsLatencyPercentile(&l, 0.99),
+           l.max * 1e6);
+    for (i = 0; i < LATENCY_BUCKETS; i++, edge *= 2)
+        if (l.hist[i] > 0) {
+            if (i < LATENCY_BUCKETS - 1) printf("  < %8.0f us %12.0f\n", edge, l.hist[i]);
+            else printf("  >=%8.0f us %12.0f\n", edge / 2, l.hist[i]);
+        }
+}
+
+/* -------------------------------------------------------------------- */
+
+static const iocshArg iocStatsLatencyProbeArg0 = { "period", iocshArgDouble };
+static const iocshArg iocStatsLatencyProbeArg1 = { "priority", iocshArgInt };
+static const iocshArg * const iocStatsLatencyProbeArgs[] = {
+    &iocStatsLatencyProbeArg0, &iocStatsLatencyProbeArg1
+};
+static const iocshFuncDef iocStatsLatencyProbeDef = {
+    "iocStatsLatencyProbe", 2, iocStatsLatencyProbeArgs
+};
+static void iocStatsLatencyProbeCall(const iocshArgBuf *args)
+{
+    iocStatsLatencyProbe(args[0].dval, args[1].ival);
+}
+
+static const iocshFuncDef iocStatsLatencyResetDef = { "iocStatsLatencyReset", 0, NULL };
+static void iocStatsLatencyResetCall(const iocshArgBuf *args)
+{
+    devIocStatsResetLatency();
+}
+
+static const iocshFuncDef iocStatsLatencyShowDef = { "iocStatsLatencyShow", 0, NULL };
+static void iocStatsLatencyShowCall(const iocshArgBuf *args)
+{
+    iocStatsLatencyShow();
+}
+
+static void devIocStatsLatencyRegister(void)
+{
+    iocshRegister(&iocStatsLatencyProbeDef, iocStatsLatencyProbeCall);
+    iocshRegister(&iocStatsLatencyResetDef, iocStatsLatencyResetCall);
+    iocshRegister(&iocStatsLatencyShowDef, iocStatsLatencyShowCall);
+}
+epicsExportRegistrar(devIocStatsLatencyRegister);
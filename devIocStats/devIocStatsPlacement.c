@@ -0,0 +1,187 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* devIocStatsPlacement.c - CPU affinity and scheduling policy of classes
+ *                          of threads, by name pattern */
+
+/*
+ *  iocStatsPlaceThreads <pattern> <cpus> <policy> <priority>
+ *	pins the threads whose name matches the glob <pattern> (e.g.
+ *	"scan-*", "cb*", "CAS-*") to the CPUs <cpus> (e.g. "2-3,6", empty
+ *	to keep) and sets their scheduling policy (OTHER, FIFO, RR, BATCH,
+ *	IDLE, empty to keep) with <priority> (FIFO and RR).  Applies at
+ *	once to the running threads and, with Base 3.15 and later, to the
+ *	threads created afterwards.  All matching rules are applied in the
+ *	order they were added.
+ *  iocStatsPlacementShow
+ *	lists the rules with the number of threads placed
+ *
+ *  The running threads are matched by the name the OS knows (at most 15
+ *  characters on Linux), new threads by their full EPICS name.  EPICS
+ *  sets the policy again when a thread's priority is changed.  The
+ *  effective placement of every thread is shown by iocStatsRtShow 1.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <epicsVersion.h>
+#include <epicsThread.h>
+#include <epicsMutex.h>
+#include <epicsString.h>
+#include <errlog.h>
+#include <iocsh.h>
+#include <epicsExport.h>
+
+#include "devIocStats.h"
+
+#if EPICS_VERSION > 3 || (EPICS_VERSION == 3 && EPICS_REVISION >= 15)
+#define HAVE_THREAD_HOOKS
+#endif
+
+#define MAX_RULES 32
+
+typedef struct {
+    char pattern[40];
+    char cpus[64];
+    char policy[12];
+    int priority;
+    unsigned long placed;
+    unsigned long failed;
+} placementRule;
+
+static placementRule rules[MAX_RULES];
+static int nRules = 0;
+static epicsMutexId rulesLock = NULL;
+
+/* Apply the matching rules, tid 0 is the calling thread */
+static void placeThread (int tid, const char *name)
+{
+    placementRule *pr;
+    int i;
+
+    epicsMutexMustLock(rulesLock);
+    for (i = 0; i < nRules; i++) {
+        pr = &rules[i];
+        if (!epicsStrGlobMatch(name, pr->pattern)) continue;
+        if (devIocStatsPlaceThread(tid, pr->cpus, pr->policy, pr->priority) == 0)
+            pr->placed++;
+        else
+            pr->failed++;
+    }
+    epicsMutexUnlock(rulesLock);
+}
+
+#ifdef HAVE_THREAD_HOOKS
+/* Runs in the new thread */
+static void placementHook (epicsThreadId id)
+{
+    placeThread(0, epicsThreadGetNameSelf());
+}
+#endif
+
+int devIocStatsPlaceThreads (const char *pattern, const char *cpus,
+                             const char *policy, int priority)
+{
+    placementRule *pr;
+    rtThread *threads;
+    int i, n;
+
+    if (!pattern || !*pattern || (!(cpus && *cpus) && !(policy && *policy))) {
+        errlogPrintf("Usage: iocStatsPlaceThreads <pattern> <cpus> <policy> <priority>\n");
+        return -1;
+    }
+    if (strlen(pattern) >= sizeof(pr->pattern) ||
+        (cpus && strlen(cpus) >= sizeof(pr->cpus)) ||
+        (policy && strlen(policy) >= sizeof(pr->policy)) ||
+        devIocStatsCheckPlacement(cpus, policy)) {
+        errlogPrintf("iocStatsPlaceThreads: %s: bad CPU list or policy, "
+                     "or not supported on this OS\n", pattern);
+        return -1;
+    }
+    if (nRules == MAX_RULES) {
+        errlogPrintf("iocStatsPlaceThreads: max. %d rules\n", MAX_RULES);
+        return -1;
+    }
+
+    if (!rulesLock) {
+        rulesLock = epicsMutexMustCreate();
+#ifdef HAVE_THREAD_HOOKS
+        epicsThreadHookAdd(placementHook);
+#endif
+    }
+    epicsMutexMustLock(rulesLock);
+    pr = &rules[nRules++];
+    memset(pr, 0, sizeof(placementRule));
+    strcpy(pr->pattern, pattern);
+    if (cpus) strcpy(pr->cpus, cpus);
+    if (policy) strcpy(pr->policy, policy);
+    pr->priority = priority;
+    epicsMutexUnlock(rulesLock);
+
+    /* Threads already running */
+    threads = calloc(1024, sizeof(rtThread));
+    if (!threads) return -1;
+    n = devIocStatsGetRtThreads(threads, 1024);
+    for (i = 0; i < n; i++)
+        if (epicsStrGlobMatch(threads[i].name, pattern))
+            placeThread(threads[i].tid, threads[i].name);
+    free(threads);
+    return 0;
+}
+
+static void iocStatsPlacementShow (void)
+{
+    placementRule *pr;
+    int i;
+
+    if (!rulesLock) return;
+#ifndef HAVE_THREAD_HOOKS
+    printf("  (no thread hooks, new threads are not placed)\n");
+#endif
+    epicsMutexMustLock(rulesLock);
+    for (i = 0; i < nRules; i++) {
+        pr = &rules[i];
+        printf("  %-20s cpus %-12s %-6s %3d  %lu placed, %lu failed\n",
+               pr->pattern, pr->cpus[0] ? pr->cpus : "-",
+               pr->policy[0] ? pr->policy : "-", pr->priority,
+               pr->placed, pr->failed);
+    }
+    epicsMutexUnlock(rulesLock);
+}
+
+/* -------------------------------------------------------------------- */
+
+static const iocshArg iocStatsPlaceThreadsArg0 = { "pattern", iocshArgString };
+static const iocshArg iocStatsPlaceThreadsArg1 = { "cpus", iocshArgString };
+static const iocshArg iocStatsPlaceThreadsArg2 = { "policy", iocshArgString };
+static const iocshArg iocStatsPlaceThreadsArg3 = { "priority", iocshArgInt };
+static const iocshArg * const iocStatsPlaceThreadsArgs[] = {
+    &iocStatsPlaceThreadsArg0, &iocStatsPlaceThreadsArg1,
+    &iocStatsPlaceThreadsArg2, &iocStatsPlaceThreadsArg3
+};
+static const iocshFuncDef iocStatsPlaceThreadsDef = {
+    "iocStatsPlaceThreads", 4, iocStatsPlaceThreadsArgs
+};
+static void iocStatsPlaceThreadsCall(const iocshArgBuf *args)
+{
+    devIocStatsPlaceThreads(args[0].sval, args[1].sval, args[2].sval,
+                            args[3].ival);
+}
+
+static const iocshFuncDef iocStatsPlacementShowDef = { "iocStatsPlacementShow", 0, NULL };
+static void iocStatsPlacementShowCall(const iocshArgBuf *args)
+{
+    iocStatsPlacementShow();
+}
+
+static void devIocStatsPlacementRegister(void)
+{
+    iocshRegister(&iocStatsPlaceThreadsDef, iocStatsPlaceThreadsCall);
+    iocshRegister(&iocStatsPlacementShowDef, iocStatsPlacementShowCall);
+}
+epicsExportRegistrar(devIocStatsPlacementRegister);
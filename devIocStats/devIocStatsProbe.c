@@ -0,0 +1,220 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* devIocStatsProbe.c - Statistics read from a number in a text file */
+
+/*
+ *  iocStatsAddFileProbe <name> <path> <pattern> <field> <mode> <period>
+ *
+ *  Registers a statistics provider <name> that reads <path> every <period>
+ *  seconds (default 10) and takes field <field> of the first line
+ *  containing <pattern> (an empty pattern matches the first line).  Fields
+ *  are separated by white space, ':' and '=', counting from 1; field 0 is
+ *  the first field after the pattern.  <mode> "value" (default) gives the
+ *  number, "rate" its change per second (counters; no update when the
+ *  counter goes backwards).  Examples:
+ *
+ *    iocStatsAddFileProbe eth0_rx_dropped
+ *	  /sys/class/net/eth0/statistics/rx_dropped "" 1 rate 10
+ *    iocStatsAddFileProbe dirty_kb /proc/meminfo "Dirty:" 0 value 10
+ *
+ *  The file stays open and is read from the start on every update.  Read
+ *  the value with an ai record, INP "@probe <name>" (or "@<name>").
+ *
+ *  iocStatsProbeShow
+ *	lists the probes with their last value and read errors
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <epicsString.h>
+#include <errlog.h>
+#include <iocsh.h>
+#include <epicsExport.h>
+
+#include "devIocStats.h"
+
+#define PROBE_LINE_SIZE 1024
+#define PROBE_PATH_SIZE 256
+#define PROBE_PATTERN_SIZE 64
+#define SEPARATORS " \t:=\r\n"
+
+typedef struct probeInfo {
+    struct probeInfo *next;
+    char name[PROVIDER_NAME_SIZE];
+    char path[PROBE_PATH_SIZE];
+    char pattern[PROBE_PATTERN_SIZE];
+    int field;
+    int rate;
+    FILE *fp;
+    int havePrev;
+    double prevValue;
+    double prevTime;
+    double value;
+    unsigned long errors;
+} probeInfo;
+
+static probeInfo *probes = NULL;
+
+/* Field <field> of a line with the pattern, 0 if found */
+static int probeParse (probeInfo *pp, char *line, double *pval)
+{
+    char *tok, *last, *num;
+    int i;
+
+    if (pp->field == 0) tok = strstr(line, pp->pattern) + strlen(pp->pattern);
+    else tok = line;
+    tok = epicsStrtok_r(tok, SEPARATORS, &last);
+    for (i = 1; tok && i < pp->field; i++)
+        tok = epicsStrtok_r(NULL, SEPARATORS, &last);
+    if (!tok) return -1;
+    *pval = strtod(tok, &num);
+    return num == tok ? -1 : 0;
+}
+
+static int probeCollect (void *arg, double *pval)
+{
+    probeInfo *pp = (probeInfo *)arg;
+    char line[PROBE_LINE_SIZE];
+    double value, now;
+    int status = -1;
+
+    if (!pp->fp) pp->fp = fopen(pp->path, "r");
+    if (!pp->fp) {
+        pp->errors++;
+        return -1;
+    }
+    /* Seeking drops the stdio buffer, so procfs/sysfs files are re-read */
+    if (fseek(pp->fp, 0L, SEEK_SET) != 0) {
+        fclose(pp->fp);
+        pp->fp = NULL;
+        pp->errors++;
+        return -1;
+    }
+    /* Lines longer than the buffer are matched in pieces */
+    while (fgets(line, sizeof(line), pp->fp)) {
+        if (!strstr(line, pp->pattern)) continue;
+        status = probeParse(pp, line, &value);
+        break;
+    }
+    clearerr(pp->fp);
+    if (status) {
+        pp->errors++;
+        return -1;
+    }
+
+    if (!pp->rate) {
+        pp->value = *pval = value;
+        return 0;
+    }
+    now = devIocStatsClock();
+    if (!pp->havePrev || value < pp->prevValue || now <= pp->prevTime) {
+        pp->havePrev = 1;
+        pp->prevValue = value;
+        pp->prevTime = now;
+        return -1;
+    }
+    pp->value = *pval = (value - pp->prevValue) / (now - pp->prevTime);
+    pp->prevValue = value;
+    pp->prevTime = now;
+    return 0;
+}
+
+int devIocStatsAddFileProbe (const char *name, const char *path,
+                             const char *pattern, int field,
+                             const char *mode, double period)
+{
+    probeInfo *pp;
+
+    if (!name || !*name || !path || !*path) {
+        errlogPrintf("iocStatsAddFileProbe: need a name and a file\n");
+        return -1;
+    }
+    if (strpbrk(name, " \t:")) {
+        errlogPrintf("iocStatsAddFileProbe: %s: no blanks or ':' in names\n", name);
+        return -1;
+    }
+    if (strlen(path) >= PROBE_PATH_SIZE ||
+        (pattern && strlen(pattern) >= PROBE_PATTERN_SIZE)) {
+        errlogPrintf("iocStatsAddFileProbe: %s: path or pattern too long\n",
+                     name);
+        return -1;
+    }
+    if (mode && *mode && strcmp(mode, "value") && strcmp(mode, "rate")) {
+        errlogPrintf("iocStatsAddFileProbe: %s: mode is value or rate\n",
+                     name);
+        return -1;
+    }
+
+    pp = calloc(1, sizeof(probeInfo));
+    if (!pp) return -1;
+    strcpy(pp->name, name);
+    strcpy(pp->path, path);
+    if (pattern) strcpy(pp->pattern, pattern);
+    pp->field = field < 0 ? 0 : field;
+    if (pp->field == 0 && !pp->pattern[0]) pp->field = 1;
+    pp->rate = mode && strcmp(mode, "rate") == 0;
+    pp->fp = fopen(path, "r");
+    if (!pp->fp)
+        errlogPrintf("iocStatsAddFileProbe: %s: can't open %s, will retry\n",
+                     name, path);
+
+    if (devIocStatsRegisterProvider(name, probeCollect, pp, period)) {
+        if (pp->fp) fclose(pp->fp);
+        free(pp);
+        return -1;
+    }
+    pp->next = probes;
+    probes = pp;
+    return 0;
+}
+
+static void iocStatsProbeShow (void)
+{
+    probeInfo *pp;
+
+    for (pp = probes; pp; pp = pp->next)
+        printf("  %-20s %-5s %14g  %lu errors  %s \"%s\" field %d\n",
+               pp->name, pp->rate ? "rate" : "value", pp->value,
+               pp->errors, pp->path, pp->pattern, pp->field);
+}
+
+/* -------------------------------------------------------------------- */
+
+static const iocshArg iocStatsAddFileProbeArg0 = { "name", iocshArgString };
+static const iocshArg iocStatsAddFileProbeArg1 = { "path", iocshArgString };
+static const iocshArg iocStatsAddFileProbeArg2 = { "pattern", iocshArgString };
+static const iocshArg iocStatsAddFileProbeArg3 = { "field", iocshArgInt };
+static const iocshArg iocStatsAddFileProbeArg4 = { "value|rate", iocshArgString };
+static const iocshArg iocStatsAddFileProbeArg5 = { "period", iocshArgDouble };
+static const iocshArg * const iocStatsAddFileProbeArgs[] = {
+    &iocStatsAddFileProbeArg0, &iocStatsAddFileProbeArg1,
+    &iocStatsAddFileProbeArg2, &iocStatsAddFileProbeArg3,
+    &iocStatsAddFileProbeArg4, &iocStatsAddFileProbeArg5
+};
+static const iocshFuncDef iocStatsAddFileProbeDef = {
+    "iocStatsAddFileProbe", 6, iocStatsAddFileProbeArgs
+};
+static void iocStatsAddFileProbeCall(const iocshArgBuf *args)
+{
+    devIocStatsAddFileProbe(args[0].sval, args[1].sval, args[2].sval,
+                            args[3].ival, args[4].sval, args[5].dval);
+}
+
+static const iocshFuncDef iocStatsProbeShowDef = { "iocStatsProbeShow", 0, NULL };
+static void iocStatsProbeShowCall(const iocshArgBuf *args)
+{
+    iocStatsProbeShow();
+}
+
+static void devIocStatsProbeRegister(void)
+{
+    iocshRegister(&iocStatsAddFileProbeDef, iocStatsAddFileProbeCall);
+    iocshRegister(&iocStatsProbeShowDef, iocStatsProbeShowCall);
+}
+epicsExportRegistrar(devIocStatsProbeRegister);
@@ -0,0 +1,409 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* devIocStatsRecorder.c - Flight recorder: the last seconds of statistics
+ *                         at a high rate, dumped to a file on trigger */
+
+/*
+ *  iocStatsRecorder <file> <parms> <seconds> <rate>
+ *	records <rate> samples per second (default 10) for the last
+ *	<seconds> (default 60).  A sample holds the time, the lateness of
+ *	the recorder thread's wakeup (ms), the IOC's CPU use since the last
+ *	sample (% of one CPU) and the current values of the ai parms in
+ *	<parms> (blank or comma separated, default ioc_cpuload sys_cpuload
+ *	fd ca_connections allocated_bytes).  Starts at iocInit, or at once
+ *	if called after.
+ *  iocStatsRecorderTrigger <parm> <op> <threshold>
+ *	dumps when <parm> is above (<op> ">") or below ("<") <threshold>,
+ *	at most once per recorder length
+ *  iocStatsRecorderDump <file>
+ *	dumps now, to stdout if no file is given
+ *
+ *  Dumps are also triggered by a bo record with OUT "@recorder_dump", at
+ *  exit and by rebootProc.  Dumps are appended to <file> as CSV, each
+ *  starting with a comment line with the trigger.
+ *
+ *  ioc_cpuload (and cpu), fd and allocated_bytes are read by the recorder
+ *  thread itself at every sample.  All other parms are the values of
+ *  their collectors, which change only once per collector period.
+ *
+ *  The recorder thread is the only writer of the ring buffer and does not
+ *  take locks.  A dump stops it from writing, copies the samples and lets
+ *  it continue; the oldest sample, which may be overwritten while the
+ *  dump starts, is left out.  Triggered and PV dumps are written by a low
+ *  priority thread, so writing the file does not delay the samples.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <epicsThread.h>
+#include <epicsMutex.h>
+#include <epicsEvent.h>
+#include <epicsTime.h>
+#include <epicsExit.h>
+#include <epicsString.h>
+#include <dbAccess.h>
+#include <errlog.h>
+#include <initHooks.h>
+#include <iocsh.h>
+#include <epicsExport.h>
+
+#include "devIocStats.h"
+
+#define REC_MAX_PARMS	16
+#define REC_PARM_SIZE	64
+#define REC_FIXED	3	/* time, late_ms, ioc_cpu */
+#define REC_DEFAULT_PARMS "ioc_cpuload sys_cpuload fd ca_connections allocated_bytes"
+
+/* Parms the recorder thread reads itself */
+#define REC_CACHED	0
+#define REC_IOC_CPU	1
+#define REC_FD		2
+#define REC_MEM		3
+static const struct {
+    const char *name;
+    int source;
+} liveParms[] = {
+    { "ioc_cpuload",	 REC_IOC_CPU },
+    { "cpu",		 REC_IOC_CPU },
+    { "fd",		 REC_FD },
+    { "allocated_bytes", REC_MEM },
+    { NULL,		 REC_CACHED }
+};
+
+static struct {
+    char file[256];
+    char names[REC_MAX_PARMS][REC_PARM_SIZE];
+    void *parms[REC_MAX_PARMS];
+    int source[REC_MAX_PARMS];
+    int nparms;
+    int ncols;
+    double period;
+    unsigned long nslots;
+    double *data;			/* nslots rows of ncols */
+    double *copy;			/* the same for a dump */
+    volatile unsigned long head;	/* samples written so far */
+    volatile int frozen;
+    volatile const char *request;	/* dump for the dump thread */
+    char trigReason[REC_PARM_SIZE + 32];
+    char trigName[REC_PARM_SIZE];
+    void *trigParm;
+    int trigAbove;
+    double trigThreshold;
+    double lastTrigger;
+    int configured;
+    int running;
+    epicsMutexId dumpLock;
+    epicsEventId dumpEvent;
+} rec;
+
+static double wallTime (void)
+{
+    epicsTimeStamp now;
+
+    epicsTimeGetCurrent(&now);
+    return now.secPastEpoch + POSIX_TIME_AT_EPICS_EPOCH + now.nsec / 1e9;
+}
+
+int devIocStatsRecorderDump (const char *file, const char *reason)
+{
+    unsigned long head, first, i;
+    double *row;
+    FILE *fp;
+    int j;
+
+    if (!rec.running) return -1;
+    if (!file) file = rec.file;
+    epicsMutexMustLock(rec.dumpLock);
+    /* Copy the rows in time order, the recorder is stopped meanwhile */
+    rec.frozen = 1;
+    head = rec.head;
+    first = head > rec.nslots - 1 ? head - (rec.nslots - 1) : 0;
+    for (i = first; i < head; i++)
+        memcpy(rec.copy + (i - first) * rec.ncols,
+               rec.data + (i % rec.nslots) * rec.ncols,
+               rec.ncols * sizeof(double));
+    rec.frozen = 0;
+
+    fp = *file ? fopen(file, "a") : stdout;
+    if (!fp) {
+        epicsMutexUnlock(rec.dumpLock);
+        errlogPrintf("iocStatsRecorder: can't open %s\n", file);
+        return -1;
+    }
+    fprintf(fp, "# iocStats flight recorder: %s, %lu samples at %g Hz\n",
+            reason ? reason : "dump", head - first, 1.0 / rec.period);
+    fprintf(fp, "time,late_ms,ioc_cpu");
+    for (j = 0; j < rec.nparms; j++) fprintf(fp, ",%s", rec.names[j]);
+    fprintf(fp, "\n");
+    for (i = 0; i < head - first; i++) {
+        row = rec.copy + i * rec.ncols;
+        fprintf(fp, "%.3f,%.3f,%.1f", row[0], row[1], row[2]);
+        for (j = REC_FIXED; j < rec.ncols; j++) fprintf(fp, ",%g", row[j]);
+        fprintf(fp, "\n");
+    }
+    if (fp != stdout) fclose(fp);
+    epicsMutexUnlock(rec.dumpLock);
+    return 0;
+}
+
+/* Dump from the dump thread (record processing must not block) */
+void devIocStatsRecorderRequest (const char *reason)
+{
+    if (!rec.running) return;
+    rec.request = reason;
+    epicsEventSignal(rec.dumpEvent);
+}
+
+static void dumpThread (void *arg)
+{
+    const char *request;
+
+    while (rec.running) {
+        epicsEventMustWait(rec.dumpEvent);
+        if ((request = (const char *)rec.request)) {
+            rec.request = NULL;
+            devIocStatsRecorderDump(NULL, request);
+        }
+    }
+}
+
+static void recorderExit (void *arg)
+{
+    devIocStatsRecorderDump(NULL, "exit");
+}
+
+static int triggered (double now)
+{
+    double val;
+
+    if (!rec.trigParm || now - rec.lastTrigger < rec.nslots * rec.period)
+        return 0;
+    val = devIocStatsParmValue(rec.trigParm);
+    if (rec.trigAbove ? val <= rec.trigThreshold : val >= rec.trigThreshold)
+        return 0;
+    rec.lastTrigger = now;
+    return 1;
+}
+
+/* Current value of a parm the recorder reads itself */
+static double liveValue (int source, double iocCpu, int ncpus)
+{
+    fdInfo fd;
+    memInfo mem;
+
+    switch (source) {
+    case REC_IOC_CPU:
+        return iocCpu / ncpus;
+    case REC_FD:
+        memset(&fd, 0, sizeof(fd));
+        devIocStatsGetFDUsage(&fd);
+        return fd.used;
+    case REC_MEM:
+        memset(&mem, 0, sizeof(mem));
+        devIocStatsGetMemUsage(&mem);
+        return mem.numBytesAlloc;
+    }
+    return 0.0;
+}
+
+static void recorderThread (void *arg)
+{
+    double next, now, cpu, lastCpu, lastTime;
+    int ncpus = devIocStatsNoOfCpus();
+    double *row;
+    int j;
+
+    if (ncpus < 1) ncpus = 1;
+    lastTime = next = devIocStatsClock();
+    lastCpu = devIocStatsProcessCpuTime();
+    rec.lastTrigger = lastTime - rec.nslots * rec.period;
+    while (rec.running) {
+        next += rec.period;
+        now = devIocStatsClock();
+        if (next > now) epicsThreadSleep(next - now);
+        now = devIocStatsClock();
+        cpu = devIocStatsProcessCpuTime();
+
+        if (!rec.frozen) {
+            row = rec.data + (rec.head % rec.nslots) * rec.ncols;
+            row[0] = wallTime();
+            row[1] = (now - next) * 1e3;
+            row[2] = now > lastTime ? 100.0 * (cpu - lastCpu) / (now - lastTime) : 0.0;
+            for (j = 0; j < rec.nparms; j++)
+                row[REC_FIXED + j] = rec.source[j] ?
+                    liveValue(rec.source[j], row[2], ncpus) : rec.parms[j] ?
+                    devIocStatsParmValue(rec.parms[j]) : 0.0;
+            rec.head++;
+        }
+        lastTime = now;
+        lastCpu = cpu;
+        /* Don't catch up after a stall */
+        if (now - next > rec.period) next = now;
+
+        if (triggered(now)) {
+            sprintf(rec.trigReason, "%s %s %g", rec.trigName,
+                    rec.trigAbove ? ">" : "<", rec.trigThreshold);
+            devIocStatsRecorderRequest(rec.trigReason);
+        }
+    }
+}
+
+static void recorderStart (void)
+{
+    int i, j;
+
+    for (j = 0; j < rec.nparms; j++) {
+        for (i = 0; liveParms[i].name; i++)
+            if (strcmp(rec.names[j], liveParms[i].name) == 0) break;
+        rec.source[j] = liveParms[i].source;
+        if (!rec.source[j] && !(rec.parms[j] = devIocStatsFindParm(rec.names[j])))
+            errlogPrintf("iocStatsRecorder: unknown parm %s\n", rec.names[j]);
+    }
+    if (rec.trigName[0] && !(rec.trigParm = devIocStatsFindParm(rec.trigName)))
+        errlogPrintf("iocStatsRecorderTrigger: unknown parm %s\n", rec.trigName);
+    rec.dumpLock = epicsMutexMustCreate();
+    rec.dumpEvent = epicsEventMustCreate(epicsEventEmpty);
+    rec.running = 1;
+    epicsAtExit(recorderExit, NULL);
+    epicsThreadCreate("iocStatsRec", epicsThreadPriorityHigh,
+                      epicsThreadGetStackSize(epicsThreadStackSmall),
+                      recorderThread, NULL);
+    epicsThreadCreate("iocStatsRecDump", epicsThreadPriorityLow,
+                      epicsThreadGetStackSize(epicsThreadStackSmall),
+                      dumpThread, NULL);
+}
+
+static void recorderInitHook (initHookState state)
+{
+    if (state == initHookAfterIocRunning && rec.configured && !rec.running)
+        recorderStart();
+}
+
+static long iocStatsRecorder (const char *file, const char *parms,
+                              double seconds, double rate)
+{
+    static int hooked = 0;
+    char list[REC_MAX_PARMS * REC_PARM_SIZE];
+    char *tok, *last;
+
+    if (rec.configured) {
+        errlogPrintf("iocStatsRecorder: already configured\n");
+        return -1;
+    }
+    if (!file || !*file) {
+        errlogPrintf("Usage: iocStatsRecorder <file> <parms> <seconds> <rate>\n");
+        return -1;
+    }
+    if (seconds <= 0) seconds = 60.0;
+    if (rate <= 0) rate = 10.0;
+    strncpy(rec.file, file, sizeof(rec.file) - 1);
+    strncpy(list, parms && *parms ? parms : REC_DEFAULT_PARMS, sizeof(list) - 1);
+    list[sizeof(list) - 1] = '\0';
+    for (tok = epicsStrtok_r(list, " ,", &last);
+         tok && rec.nparms < REC_MAX_PARMS;
+         tok = epicsStrtok_r(NULL, " ,", &last)) {
+        strncpy(rec.names[rec.nparms], tok, REC_PARM_SIZE - 1);
+        rec.nparms++;
+    }
+    rec.ncols = REC_FIXED + rec.nparms;
+    rec.period = 1.0 / rate;
+    rec.nslots = (unsigned long)(seconds * rate + 0.5) + 1;
+    rec.data = calloc(rec.nslots * rec.ncols, sizeof(double));
+    rec.copy = calloc(rec.nslots * rec.ncols, sizeof(double));
+    if (!rec.data || !rec.copy) {
+        free(rec.data);
+        free(rec.copy);
+        rec.data = rec.copy = NULL;
+        errlogPrintf("iocStatsRecorder: no memory for %lu samples\n", rec.nslots);
+        return -1;
+    }
+    rec.configured = 1;
+    printf("iocStatsRecorder: %lu samples of %d values, %lu kB\n", rec.nslots,
+           rec.ncols, (unsigned long)(2 * rec.nslots * rec.ncols * sizeof(double) / 1024));
+
+    if (interruptAccept) recorderStart();
+    else if (!hooked) {
+        initHookRegister(recorderInitHook);
+        hooked = 1;
+    }
+    return 0;
+}
+
+static long iocStatsRecorderTrigger (const char *parm, const char *op,
+                                     double threshold)
+{
+    if (!parm || !*parm || strlen(parm) >= REC_PARM_SIZE || !op ||
+        (strcmp(op, ">") && strcmp(op, "<"))) {
+        errlogPrintf("Usage: iocStatsRecorderTrigger <parm> <'>'|'<'> <threshold>\n");
+        return -1;
+    }
+    rec.trigParm = NULL;
+    strcpy(rec.trigName, parm);
+    rec.trigAbove = (op[0] == '>');
+    rec.trigThreshold = threshold;
+    if (rec.running && !(rec.trigParm = devIocStatsFindParm(parm))) {
+        errlogPrintf("iocStatsRecorderTrigger: unknown parm %s\n", parm);
+        return -1;
+    }
+    return 0;
+}
+
+/* -------------------------------------------------------------------- */
+
+static const iocshArg iocStatsRecorderArg0 = { "file", iocshArgString };
+static const iocshArg iocStatsRecorderArg1 = { "parms", iocshArgString };
+static const iocshArg iocStatsRecorderArg2 = { "seconds", iocshArgDouble };
+static const iocshArg iocStatsRecorderArg3 = { "rate", iocshArgDouble };
+static const iocshArg * const iocStatsRecorderArgs[] = {
+    &iocStatsRecorderArg0, &iocStatsRecorderArg1,
+    &iocStatsRecorderArg2, &iocStatsRecorderArg3
+};
+static const iocshFuncDef iocStatsRecorderDef = {
+    "iocStatsRecorder", 4, iocStatsRecorderArgs
+};
+static void iocStatsRecorderCall(const iocshArgBuf *args)
+{
+    iocStatsRecorder(args[0].sval, args[1].sval, args[2].dval, args[3].dval);
+}
+
+static const iocshArg iocStatsRecorderTriggerArg0 = { "parm", iocshArgString };
+static const iocshArg iocStatsRecorderTriggerArg1 = { "'>'|'<'", iocshArgString };
+static const iocshArg iocStatsRecorderTriggerArg2 = { "threshold", iocshArgDouble };
+static const iocshArg * const iocStatsRecorderTriggerArgs[] = {
+    &iocStatsRecorderTriggerArg0, &iocStatsRecorderTriggerArg1,
+    &iocStatsRecorderTriggerArg2
+};
+static const iocshFuncDef iocStatsRecorderTriggerDef = {
+    "iocStatsRecorderTrigger", 3, iocStatsRecorderTriggerArgs
+};
+static void iocStatsRecorderTriggerCall(const iocshArgBuf *args)
+{
+    iocStatsRecorderTrigger(args[0].sval, args[1].sval, args[2].dval);
+}
+
+static const iocshArg iocStatsRecorderDumpArg0 = { "file", iocshArgString };
+static const iocshArg * const iocStatsRecorderDumpArgs[] = {
+    &iocStatsRecorderDumpArg0
+};
+static const iocshFuncDef iocStatsRecorderDumpDef = {
+    "iocStatsRecorderDump", 1, iocStatsRecorderDumpArgs
+};
+static void iocStatsRecorderDumpCall(const iocshArgBuf *args)
+{
+    if (devIocStatsRecorderDump(args[0].sval ? args[0].sval : "", "iocsh"))
+        printf("iocStatsRecorderDump: recorder not running\n");
+}
+
+static void devIocStatsRecorderRegister(void)
+{
+    iocshRegister(&iocStatsRecorderDef, iocStatsRecorderCall);
+    iocshRegister(&iocStatsRecorderTriggerDef, iocStatsRecorderTriggerCall);
+    iocshRegister(&iocStatsRecorderDumpDef, iocStatsRecorderDumpCall);
+}
+epicsExportRegistrar(devIocStatsRecorderRegister);
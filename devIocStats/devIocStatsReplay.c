@@ -0,0 +1,269 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* devIocStatsReplay.c - Replaceable procfs root and clock of the collectors */
+
+/*
+ *  The Linux OSD parts build their /proc paths with devIocStatsProcPath()
+ *  and take their time stamps from devIocStatsGetTime(), so both can be
+ *  redirected to replay recorded /proc snapshots with a fixed clock:
+ *
+ *  iocStatsProcRoot <dir>
+ *	read /proc from <dir>/proc, an empty <dir> restores /proc
+ *  iocStatsClock <seconds>
+ *	freeze the collectors' clock at <seconds> past the EPICS epoch,
+ *	a negative value restores the system clock
+ *  iocStatsReplay <dir> <interval> <count>
+ *	run the collectors over the snapshots <dir>/0 ... <dir>/<count-1>,
+ *	taken <interval> seconds apart, and print their results and the
+ *	time each collector took
+ *
+ *  iocStatsReplay re-initializes the collectors with the real /proc when
+ *  done.  The procfs root and the clock are global, so they can't be
+ *  changed while collectors are running: use these commands before iocInit
+ *  or in an IOC without statistics records.  Restoring /proc and the
+ *  system clock is always allowed.
+ */
+
+#include <string.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <epicsTime.h>
+#include <epicsStdio.h>
+#include <errlog.h>
+#include <iocsh.h>
+#include <epicsExport.h>
+
+#include "devIocStats.h"
+
+#define PATH_SIZE 256
+
+static char procRoot[PATH_SIZE] = "";
+static int procCpus = 0;
+static int fixedClock = 0;
+static epicsTimeStamp fixedTime;
+
+const char *devIocStatsProcPath (char *buf, size_t size, const char *fmt, ...)
+{
+    va_list args;
+    size_t len = strlen(procRoot);
+
+    if (len >= size) len = size - 1;
+    memcpy(buf, procRoot, len);
+    va_start(args, fmt);
+    vsnprintf(buf + len, size - len, fmt, args);
+    va_end(args);
+    return buf;
+}
+
+int devIocStatsReplaying (void)
+{
+    return procRoot[0] != '\0' || fixedClock;
+}
+
+/* The number of cpu<N> lines of a snapshot's /proc/stat */
+static int cpusFromProc (void)
+{
+    char path[PATH_SIZE];
+    char line[256];
+    int n = 0;
+    FILE *fp;
+
+    fp = fopen(devIocStatsProcPath(path, sizeof(path), "/proc/stat"), "r");
+    if (!fp) return 1;
+    while (fgets(line, sizeof(line), fp))
+        if (strncmp(line, "cpu", 3) == 0 && line[3] >= '0' && line[3] <= '9')
+            n++;
+    fclose(fp);
+    return n ? n : 1;
+}
+
+int devIocStatsNoOfCpus (void)
+{
+    return procRoot[0] ? procCpus : NO_OF_CPUS;
+}
+
+/* Returns -1 if collectors are running */
+int devIocStatsSetProcRoot (const char *dir)
+{
+    size_t len;
+
+    if (!dir) dir = "";
+    if (*dir && devIocStatsCollectorsRunning()) {
+        errlogPrintf("devIocStatsSetProcRoot: collectors are running\n");
+        return -1;
+    }
+    strncpy(procRoot, dir, sizeof(procRoot) - 1);
+    procRoot[sizeof(procRoot) - 1] = '\0';
+    /* The paths start with '/' */
+    len = strlen(procRoot);
+    while (len > 0 && procRoot[len - 1] == '/') procRoot[--len] = '\0';
+    if (procRoot[0]) procCpus = cpusFromProc();
+    return 0;
+}
+
+void devIocStatsGetTime (epicsTimeStamp *pts)
+{
+    if (fixedClock) *pts = fixedTime;
+    else epicsTimeGetCurrent(pts);
+}
+
+/* Returns -1 if collectors are running */
+int devIocStatsSetTime (double seconds)
+{
+    if (seconds < 0) {
+        fixedClock = 0;
+        return 0;
+    }
+    if (devIocStatsCollectorsRunning()) {
+        errlogPrintf("devIocStatsSetTime: collectors are running\n");
+        return -1;
+    }
+    fixedTime.secPastEpoch = (epicsUInt32)seconds;
+    fixedTime.nsec = (epicsUInt32)((seconds - fixedTime.secPastEpoch) * 1e9);
+    fixedClock = 1;
+    return 0;
+}
+
+/* -------------------------------------------------------------------- */
+
+static void replayInit (void)
+{
+    loadInfo load;
+
+    devIocStatsInitCpuUsage();
+    devIocStatsInitCpuUtilization(&load);
+    devIocStatsInitSysLoad();
+    devIocStatsInitMemUsage();
+    devIocStatsInitFDUsage();
+    devIocStatsInitIOUsage();
+}
+
+static long iocStatsReplay (const char *dir, double interval, int count)
+{
+    static const char *names[] = {
+        "cpu", "ioc_cpu", "sysload", "mem", "fd", "io"
+    };
+    char root[PATH_SIZE];
+    double t[6], sum[6];
+    double start;
+    loadInfo load;
+    sysLoadInfo sysLoad;
+    memInfo mem;
+    fdInfo fd;
+    ioInfo io;
+    int i, j;
+
+    if (!dir || !*dir || count < 2 || interval <= 0) {
+        errlogPrintf("iocStatsReplay: need a snapshot directory, "
+                     "an interval > 0 and at least 2 snapshots\n");
+        return -1;
+    }
+    if (devIocStatsCollectorsRunning()) {
+        errlogPrintf("iocStatsReplay: collectors are running\n");
+        return -1;
+    }
+    memset(sum, 0, sizeof(sum));
+    memset(&load, 0, sizeof(load));
+
+    for (i = 0; i < count; i++) {
+        epicsSnprintf(root, sizeof(root), "%s/%d", dir, i);
+        devIocStatsSetProcRoot(root);
+        devIocStatsSetTime(i * interval);
+        if (i == 0) {
+            replayInit();
+            continue;
+        }
+
+        start = devIocStatsClock();
+        devIocStatsGetCpuUsage(&load);
+        t[0] = devIocStatsClock() - start;
+        start = devIocStatsClock();
+        devIocStatsGetCpuUtilization(&load);
+        t[1] = devIocStatsClock() - start;
+        start = devIocStatsClock();
+        devIocStatsGetSysLoad(&sysLoad);
+        t[2] = devIocStatsClock() - start;
+        start = devIocStatsClock();
+        devIocStatsGetMemUsage(&mem);
+        t[3] = devIocStatsClock() - start;
+        start = devIocStatsClock();
+        devIocStatsGetFDUsage(&fd);
+        t[4] = devIocStatsClock() - start;
+        start = devIocStatsClock();
+        devIocStatsGetIOUsage(&io);
+        t[5] = devIocStatsClock() - start;
+        for (j = 0; j < 6; j++) sum[j] += t[j];
+
+        printf("%s (%d CPUs)\n", root, devIocStatsNoOfCpus());
+        printf("  cpu %.2f%%  ioc_cpu %.2f%%  ioc_runq_wait %.3f ms/s\n",
+               load.cpuLoad, load.iocLoad, load.iocRunqWait);
+        printf("  load_avg %.3f %.3f %.3f  runnable %d/%d  runq_wait %.3f ms/s\n",
+               sysLoad.loadAvg[0], sysLoad.loadAvg[1], sysLoad.loadAvg[2],
+               sysLoad.runnable, sysLoad.total, sysLoad.runqWait);
+        printf("  mem alloc %.0f free %.0f total %.0f  fd %d/%d\n",
+               mem.numBytesAlloc, mem.numBytesFree, mem.numBytesTotal,
+               fd.used, fd.max);
+        printf("  io read %.1f write %.1f B/s  blkio_delay %.3f ms/s\n",
+               io.readBytes, io.writeBytes, io.blkioDelay);
+    }
+
+    printf("Mean collector time (us):");
+    for (j = 0; j < 6; j++)
+        printf("  %s %.1f", names[j], 1e6 * sum[j] / (count - 1));
+    printf("\n");
+
+    devIocStatsSetProcRoot("");
+    devIocStatsSetTime(-1);
+    replayInit();
+    return 0;
+}
+
+/* -------------------------------------------------------------------- */
+
+static const iocshArg iocStatsProcRootArg0 = { "dir", iocshArgString };
+static const iocshArg * const iocStatsProcRootArgs[] = { &iocStatsProcRootArg0 };
+static const iocshFuncDef iocStatsProcRootDef = {
+    "iocStatsProcRoot", 1, iocStatsProcRootArgs
+};
+static void iocStatsProcRootCall(const iocshArgBuf *args)
+{
+    devIocStatsSetProcRoot(args[0].sval);
+}
+
+static const iocshArg iocStatsClockArg0 = { "seconds", iocshArgDouble };
+static const iocshArg * const iocStatsClockArgs[] = { &iocStatsClockArg0 };
+static const iocshFuncDef iocStatsClockDef = {
+    "iocStatsClock", 1, iocStatsClockArgs
+};
+static void iocStatsClockCall(const iocshArgBuf *args)
+{
+    devIocStatsSetTime(args[0].dval);
+}
+
+static const iocshArg iocStatsReplayArg0 = { "dir", iocshArgString };
+static const iocshArg iocStatsReplayArg1 = { "interval", iocshArgDouble };
+static const iocshArg iocStatsReplayArg2 = { "count", iocshArgInt };
+static const iocshArg * const iocStatsReplayArgs[] = {
+    &iocStatsReplayArg0, &iocStatsReplayArg1, &iocStatsReplayArg2
+};
+static const iocshFuncDef iocStatsReplayDef = {
+    "iocStatsReplay", 3, iocStatsReplayArgs
+};
+static void iocStatsReplayCall(const iocshArgBuf *args)
+{
+    iocStatsReplay(args[0].sval, args[1].dval, args[2].ival);
+}
+
+static void devIocStatsReplayRegister(void)
+{
+    iocshRegister(&iocStatsProcRootDef, iocStatsProcRootCall);
+    iocshRegister(&iocStatsClockDef, iocStatsClockCall);
+    iocshRegister(&iocStatsReplayDef, iocStatsReplayCall);
+}
+epicsExportRegistrar(devIocStatsReplayRegister);
@@ -0,0 +1,55 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* devIocStatsShm.h - Layout of the shared memory statistics segment */
+
+/*
+ *  Each IOC with devIocStatsShm set publishes its statistics snapshot in
+ *  the POSIX shared memory object IOCSTATS_SHM_PREFIX<pid>.  The layout
+ *  is fixed for a given version; new fields are only appended, and the
+ *  size member tells readers how much of the segment is valid.
+ *
+ *  Writers and readers use a sequence lock: the writer increments seq
+ *  before and after updating the data (seq is odd during the update).
+ *  A reader copies the segment and retries while seq was odd or has
+ *  changed during the copy.
+ *
+ *  This header is also used by the iocstat-top tool and must not depend
+ *  on EPICS headers.
+ */
+
+#ifndef INC_devIocStatsShm_H
+#define INC_devIocStatsShm_H
+
+#define IOCSTATS_SHM_PREFIX   "/iocStats."
+#define IOCSTATS_SHM_MAGIC    0x49535453	/* "ISTS" */
+#define IOCSTATS_SHM_VERSION  1
+#define IOCSTATS_SHM_NAME_SIZE 40
+
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int size;			/* sizeof(iocStatsShm) of the writer */
+    volatile unsigned int seq;		/* odd while being updated */
+    int pid;
+    int noOfCpus;
+    char name[IOCSTATS_SHM_NAME_SIZE];	/* IOC name ($IOC), may be empty */
+    double updateTime;			/* POSIX time of the last update */
+    double iocCpuLoad;			/* % */
+    double sysCpuLoad;			/* % */
+    double memAlloc;			/* bytes */
+    double memFree;			/* bytes */
+    double memTotal;			/* bytes */
+    double fdUsed;
+    double fdMax;
+    double caClients;
+    double caConnections;
+    double scanLateness;		/* s, worst collector timer lateness */
+    double ioReadRate;			/* bytes/s */
+    double ioWriteRate;			/* bytes/s */
+} iocStatsShm;
+
+#endif /* INC_devIocStatsShm_H */
@@ -129,6 +129,7 @@ struct validGetStrParms
 };
 typedef struct validGetStrParms validGetStrParms;
 
+static long stringin_report(int level);
 static long stringin_init(int pass);
 static long stringin_init_record(stringinRecord*);
 static long stringin_read(stringinRecord*);
@@ -179,7 +180,7 @@ static validGetStrParms statsGetStrParms[]={
 	{ NULL,NULL,0 }
 };
 
-sStats devStringinStats  ={5,NULL,stringin_init,stringin_init_record,NULL,stringin_read};
+sStats devStringinStats  ={5,stringin_report,stringin_init,stringin_init_record,NULL,stringin_read};
 sStats devStringinEnvVar ={5,NULL,NULL,envvar_init_record,  NULL,envvar_read  };
 sStats devStringinEpics  ={5,NULL,NULL,epics_init_record,   NULL,epics_read   };
 epicsExportAddress(dset,devStringinStats);
@@ -279,14 +280,22 @@ static long epics_init_record(stringinRecord* pr)
         return S_db_badField;
 }
 
+static long stringin_report(int level)
+{
+	devIocStatsShowRead(READ_STRINGIN);
+	return 0;
+}
+
 static long stringin_read(stringinRecord* pr)
 {
+	double start = devIocStatsClock();
 	pvtArea* pvt=(pvtArea*)pr->dpvt;
 
 	if (!pvt) return S_dev_badInpType;
 
 	statsGetStrParms[pvt->index].func(pr->val);
 	pr->udf=0;
+	devIocStatsReadTime(READ_STRINGIN, start);
 	return(0);	/* success */
 }
 
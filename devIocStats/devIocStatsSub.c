@@ -51,6 +51,7 @@
 
         A taskDelay is needed before the reboot
         to allow the reboot message to be logged.
+        The flight recorder, if running, is dumped.
 
   Side: Memory is cleared if BOOT_CLEAR is set.
         A reboot is initiated.
@@ -67,6 +68,7 @@ static long rebootProc(struct subRecord *psub)
       (psub->e < 0.5) && (psub->f < 0.5) &&
       (psub->l > 0.5)) {
      epicsPrintf("IOC reboot started\n");
+     devIocStatsRecorderDump(NULL, "reboot");
      epicsThreadSleep(1.0);
      reboot((int)(psub->g + 0.1));
   }
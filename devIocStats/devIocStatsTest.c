@@ -26,9 +26,17 @@
  *		Argonne National Laboratory
  */
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "epicsStdio.h"
 #include "epicsThread.h"
 #include "epicsTime.h"
+#include "epicsMutex.h"
+#include "callback.h"
+#include "osiSock.h"
+#include "iocsh.h"
+#include "epicsExport.h"
 
 /* ----------test routines----------------- */
 
@@ -88,3 +96,453 @@ double         fac = vxStats_busyloop_period/(double)100.0;
 	}
 }
 
+/* ----------load generators----------------- */
+
+/*
+ * Synthetic loads to reproduce failure modes and check alarm limits,
+ * controlled from iocsh while the IOC runs.  Calling a command again
+ * changes the running generator, a rate of 0 (or loadStop) stops it.
+ *
+ *	loadCpu <nthreads> <duty>		CPU burners, duty in %
+ *	loadHeap <bytes/s> <maxblock> <maxbytes>	alloc and fragment heap
+ *	loadFd <nopen> <churn/s>		hold and cycle sockets
+ *	loadThreads <create/s> <lifetime>	short lived threads
+ *	loadCallback <req/s> <priority> <usec>	flood a callback queue
+ *	loadStop <generator>			cpu, heap, fd, threads,
+ *						callback, or all if empty
+ *	loadShow
+ */
+
+#define LOAD_PERIOD	0.01	/* sec between steps of the generators */
+#define MAX_BURNERS	256
+#define MAX_BLOCKS	65536
+#define MAX_SOCKS	65536
+
+static epicsMutexId loadLock = NULL;
+
+static volatile int cpuThreads = 0;
+static volatile unsigned cpuDuty = 0;
+static int burnerAlive[MAX_BURNERS];
+
+static volatile double heapRate = 0;
+static volatile size_t heapMaxBlock = 4096;
+static volatile size_t heapMax = 64*1024*1024;
+static int heapRunning = 0;
+static void *heapBlocks[MAX_BLOCKS];
+static size_t heapSizes[MAX_BLOCKS];
+static size_t heapBytes = 0;
+static int heapCount = 0;
+
+static volatile int fdOpen = 0;
+static volatile double fdRate = 0;
+static int fdRunning = 0;
+static SOCKET fdSocks[MAX_SOCKS];
+static int fdCount = 0;
+
+static volatile double threadRate = 0;
+static volatile double threadLife = 1.0;
+static int threadRunning = 0;
+static volatile int threadsAlive = 0;
+
+static volatile double cbRate = 0;
+static volatile int cbPriority = priorityLow;
+static volatile double cbWork = 0;
+static int cbRunning = 0;
+static CALLBACK cbCallback[NUM_CALLBACK_PRIORITIES];
+static volatile unsigned long cbRequested = 0;
+static volatile unsigned long cbDone = 0;
+
+static void loadInit(void)
+{
+	if (!loadLock) loadLock = epicsMutexMustCreate();
+}
+
+static void spin(double seconds)
+{
+	epicsTimeStamp then, now;
+
+	epicsTimeGetCurrent(&then);
+	do {
+		epicsTimeGetCurrent(&now);
+	} while ( epicsTimeDiffInSeconds(&now,&then) < seconds );
+}
+
+/* Number of whole steps due at <rate> per second since the last call,
+   carrying the rest */
+static int stepsDue(double rate, double *carry, epicsTimeStamp *last)
+{
+	epicsTimeStamp now;
+	double elapsed;
+	int n;
+
+	epicsTimeGetCurrent(&now);
+	elapsed = last->secPastEpoch ? epicsTimeDiffInSeconds(&now, last) : LOAD_PERIOD;
+	*last = now;
+	if (elapsed > 1.0) elapsed = 1.0;
+	*carry += rate * elapsed;
+	n = (int)*carry;
+	*carry -= n;
+	return n;
+}
+
+static void startGen(const char *name, int *running, EPICSTHREADFUNC func)
+{
+	if (*running) return;
+	*running = 1;
+	epicsThreadCreate(name, epicsThreadPriorityLow,
+			  epicsThreadGetStackSize(epicsThreadStackSmall), func, NULL);
+}
+
+/* Returns 1 if the generator is to stop; the condition is checked, the
+   resources released and the generator marked stopped under the lock, so
+   a command changing the settings either keeps it running or restarts it */
+static int stopGen(int *running, int (*stop)(void), void (*cleanup)(void))
+{
+	int done;
+
+	epicsMutexMustLock(loadLock);
+	done = stop();
+	if (done) {
+		if (cleanup) cleanup();
+		*running = 0;
+	}
+	epicsMutexUnlock(loadLock);
+	return done;
+}
+
+static int heapStop(void)	{ return heapRate <= 0; }
+static int fdStop(void)		{ return fdOpen <= 0 && fdRate <= 0; }
+static int threadStop(void)	{ return threadRate <= 0; }
+static int cbStop(void)		{ return cbRate <= 0; }
+
+static void cpuBurner(void *arg)
+{
+	int id = (int)(size_t)arg;
+	double period = 10 * LOAD_PERIOD;
+
+	for (;;) {
+		epicsMutexMustLock(loadLock);
+		if (id >= cpuThreads) {
+			burnerAlive[id] = 0;
+			epicsMutexUnlock(loadLock);
+			return;
+		}
+		epicsMutexUnlock(loadLock);
+		spin(period * cpuDuty / 100.0);
+		if (cpuDuty < 100)
+			epicsThreadSleep(period * (100 - cpuDuty) / 100.0);
+	}
+}
+
+static void heapFree(void)
+{
+	while (heapCount) free(heapBlocks[--heapCount]);
+	heapBytes = 0;
+}
+
+static void heapGen(void *arg)
+{
+	epicsTimeStamp last = { 0, 0 };
+	double carry = 0;
+	size_t size;
+	int i, n;
+
+	while (!stopGen(&heapRunning, heapStop, heapFree)) {
+		n = stepsDue(heapRate, &carry, &last);
+		while (n > 0) {
+			/* Free random blocks to leave holes of assorted sizes */
+			while (heapCount && (heapCount == MAX_BLOCKS || heapBytes >= heapMax)) {
+				i = rand() % heapCount;
+				free(heapBlocks[i]);
+				heapBytes -= heapSizes[i];
+				heapBlocks[i] = heapBlocks[--heapCount];
+				heapSizes[i] = heapSizes[heapCount];
+			}
+			size = 1 + rand() % heapMaxBlock;
+			if ((size_t)n < size) size = n;
+			heapBlocks[heapCount] = malloc(size);
+			if (heapBlocks[heapCount]) {
+				memset(heapBlocks[heapCount], 0x55, size);
+				heapSizes[heapCount++] = size;
+				heapBytes += size;
+			}
+			n -= size;
+		}
+		epicsThreadSleep(LOAD_PERIOD);
+	}
+}
+
+static void fdClose(void)
+{
+	while (fdCount) epicsSocketDestroy(fdSocks[--fdCount]);
+}
+
+static void fdGen(void *arg)
+{
+	epicsTimeStamp last = { 0, 0 };
+	double carry = 0;
+	SOCKET sock;
+	int n;
+
+	while (!stopGen(&fdRunning, fdStop, fdClose)) {
+		while (fdCount > fdOpen)
+			epicsSocketDestroy(fdSocks[--fdCount]);
+		while (fdCount < fdOpen && fdCount < MAX_SOCKS) {
+			sock = epicsSocketCreate(AF_INET, SOCK_DGRAM, 0);
+			if (sock == INVALID_SOCKET) break;
+			fdSocks[fdCount++] = sock;
+		}
+		for (n = stepsDue(fdRate, &carry, &last); n > 0; n--) {
+			sock = epicsSocketCreate(AF_INET, SOCK_DGRAM, 0);
+			if (sock == INVALID_SOCKET) break;
+			epicsSocketDestroy(sock);
+		}
+		epicsThreadSleep(LOAD_PERIOD);
+	}
+}
+
+static void shortThread(void *arg)
+{
+	epicsThreadSleep(threadLife);
+	epicsMutexMustLock(loadLock);
+	threadsAlive--;
+	epicsMutexUnlock(loadLock);
+}
+
+static void threadGen(void *arg)
+{
+	epicsTimeStamp last = { 0, 0 };
+	double carry = 0;
+	int n;
+
+	while (!stopGen(&threadRunning, threadStop, NULL)) {
+		for (n = stepsDue(threadRate, &carry, &last); n > 0; n--) {
+			epicsMutexMustLock(loadLock);
+			threadsAlive++;
+			epicsMutexUnlock(loadLock);
+			if (!epicsThreadCreate("loadShort", epicsThreadPriorityLow,
+					       epicsThreadGetStackSize(epicsThreadStackSmall),
+					       shortThread, NULL)) {
+				epicsMutexMustLock(loadLock);
+				threadsAlive--;
+				epicsMutexUnlock(loadLock);
+			}
+		}
+		epicsThreadSleep(LOAD_PERIOD);
+	}
+}
+
+static void cbFunc(CALLBACK *pcb)
+{
+	if (cbWork > 0) spin(cbWork);
+	cbDone++;
+}
+
+static void callbackGen(void *arg)
+{
+	epicsTimeStamp last = { 0, 0 };
+	double carry = 0;
+	int n;
+
+	while (!stopGen(&cbRunning, cbStop, NULL)) {
+		/* A CALLBACK may be queued more than once */
+		for (n = stepsDue(cbRate, &carry, &last); n > 0; n--) {
+			callbackRequest(&cbCallback[cbPriority]);
+			cbRequested++;
+		}
+		epicsThreadSleep(LOAD_PERIOD);
+	}
+}
+
+void loadCpu(int nthreads, int duty)
+{
+	char name[32];
+	int i;
+
+	loadInit();
+	if (nthreads < 0) nthreads = 0;
+	if (nthreads > MAX_BURNERS) nthreads = MAX_BURNERS;
+	if (duty < 0) duty = 0;
+	if (duty > 100) duty = 100;
+	epicsMutexMustLock(loadLock);
+	cpuDuty = duty;
+	cpuThreads = nthreads;
+	for (i = 0; i < nthreads; i++) {
+		if (burnerAlive[i]) continue;
+		burnerAlive[i] = 1;
+		sprintf(name, "loadCpu%d", i);
+		epicsThreadCreate(name, epicsThreadPriorityLow,
+				  epicsThreadGetStackSize(epicsThreadStackSmall),
+				  cpuBurner, (void *)(size_t)i);
+	}
+	epicsMutexUnlock(loadLock);
+}
+
+void loadHeap(double rate, int maxblock, double maxbytes)
+{
+	loadInit();
+	if (maxblock > 0) heapMaxBlock = maxblock;
+	if (maxbytes > 0) heapMax = (size_t)maxbytes;
+	epicsMutexMustLock(loadLock);
+	heapRate = rate;
+	if (rate > 0) startGen("loadHeap", &heapRunning, heapGen);
+	epicsMutexUnlock(loadLock);
+}
+
+void loadFd(int nopen, double rate)
+{
+	loadInit();
+	if (!osiSockAttach()) return;
+	epicsMutexMustLock(loadLock);
+	fdOpen = nopen < 0 ? 0 : nopen;
+	fdRate = rate;
+	if (fdOpen > 0 || rate > 0) startGen("loadFd", &fdRunning, fdGen);
+	epicsMutexUnlock(loadLock);
+}
+
+void loadThreads(double rate, double lifetime)
+{
+	loadInit();
+	epicsMutexMustLock(loadLock);
+	threadRate = rate;
+	threadLife = lifetime > 0 ? lifetime : 1.0;
+	if (rate > 0) startGen("loadThreads", &threadRunning, threadGen);
+	epicsMutexUnlock(loadLock);
+}
+
+void loadCallback(double rate, int priority, double usec)
+{
+	int i;
+
+	loadInit();
+	if (priority < 0 || priority >= NUM_CALLBACK_PRIORITIES)
+		priority = priorityLow;
+	epicsMutexMustLock(loadLock);
+	for (i = 0; i < NUM_CALLBACK_PRIORITIES; i++) {
+		callbackSetCallback(cbFunc, &cbCallback[i]);
+		callbackSetPriority(i, &cbCallback[i]);
+	}
+	cbPriority = priority;
+	cbWork = usec > 0 ? usec / 1e6 : 0;
+	cbRate = rate;
+	if (rate > 0) startGen("loadCallback", &cbRunning, callbackGen);
+	epicsMutexUnlock(loadLock);
+}
+
+void loadStop(const char *what)
+{
+	int all = !what || !*what || strcmp(what, "all") == 0;
+
+	if (all || strcmp(what, "cpu") == 0) loadCpu(0, 0);
+	if (all || strcmp(what, "heap") == 0) loadHeap(0, 0, 0);
+	if (all || strcmp(what, "fd") == 0) {
+		loadInit();
+		epicsMutexMustLock(loadLock);
+		fdOpen = 0;
+		fdRate = 0;
+		epicsMutexUnlock(loadLock);
+	}
+	if (all || strcmp(what, "threads") == 0) loadThreads(0, 0);
+	if (all || strcmp(what, "callback") == 0) loadCallback(0, 0, 0);
+}
+
+void loadShow(void)
+{
+	int i, burners = 0;
+
+	loadInit();
+	epicsMutexMustLock(loadLock);
+	for (i = 0; i < MAX_BURNERS; i++) burners += burnerAlive[i];
+	epicsMutexUnlock(loadLock);
+	printf("cpu:      %d burner threads at %u%%\n", burners, cpuDuty);
+	printf("heap:     %s, %.0f bytes/s, %d blocks, %lu bytes (max %lu)\n",
+	       heapRunning ? "on" : "off", heapRate, heapCount,
+	       (unsigned long)heapBytes, (unsigned long)heapMax);
+	printf("fd:       %s, %d open, %.0f open/close per s\n",
+	       fdRunning ? "on" : "off", fdCount, fdRate);
+	printf("threads:  %s, %.0f per s, %d alive\n",
+	       threadRunning ? "on" : "off", threadRate, threadsAlive);
+	printf("callback: %s, %.0f per s at priority %d, %lu requested, %lu done\n",
+	       cbRunning ? "on" : "off", cbRate, cbPriority, cbRequested, cbDone);
+}
+
+/* -------------------------------------------------------------------- */
+
+static const iocshArg loadCpuArg0 = { "nthreads", iocshArgInt };
+static const iocshArg loadCpuArg1 = { "duty", iocshArgInt };
+static const iocshArg * const loadCpuArgs[] = { &loadCpuArg0, &loadCpuArg1 };
+static const iocshFuncDef loadCpuDef = { "loadCpu", 2, loadCpuArgs };
+static void loadCpuCall(const iocshArgBuf *args)
+{
+	loadCpu(args[0].ival, args[1].ival);
+}
+
+static const iocshArg loadHeapArg0 = { "bytes/s", iocshArgDouble };
+static const iocshArg loadHeapArg1 = { "maxblock", iocshArgInt };
+static const iocshArg loadHeapArg2 = { "maxbytes", iocshArgDouble };
+static const iocshArg * const loadHeapArgs[] = {
+	&loadHeapArg0, &loadHeapArg1, &loadHeapArg2
+};
+static const iocshFuncDef loadHeapDef = { "loadHeap", 3, loadHeapArgs };
+static void loadHeapCall(const iocshArgBuf *args)
+{
+	loadHeap(args[0].dval, args[1].ival, args[2].dval);
+}
+
+static const iocshArg loadFdArg0 = { "nopen", iocshArgInt };
+static const iocshArg loadFdArg1 = { "churn/s", iocshArgDouble };
+static const iocshArg * const loadFdArgs[] = { &loadFdArg0, &loadFdArg1 };
+static const iocshFuncDef loadFdDef = { "loadFd", 2, loadFdArgs };
+static void loadFdCall(const iocshArgBuf *args)
+{
+	loadFd(args[0].ival, args[1].dval);
+}
+
+static const iocshArg loadThreadsArg0 = { "create/s", iocshArgDouble };
+static const iocshArg loadThreadsArg1 = { "lifetime", iocshArgDouble };
+static const iocshArg * const loadThreadsArgs[] = {
+	&loadThreadsArg0, &loadThreadsArg1
+};
+static const iocshFuncDef loadThreadsDef = { "loadThreads", 2, loadThreadsArgs };
+static void loadThreadsCall(const iocshArgBuf *args)
+{
+	loadThreads(args[0].dval, args[1].dval);
+}
+
+static const iocshArg loadCallbackArg0 = { "req/s", iocshArgDouble };
+static const iocshArg loadCallbackArg1 = { "priority", iocshArgInt };
+static const iocshArg loadCallbackArg2 = { "usec", iocshArgDouble };
+static const iocshArg * const loadCallbackArgs[] = {
+	&loadCallbackArg0, &loadCallbackArg1, &loadCallbackArg2
+};
+static const iocshFuncDef loadCallbackDef = { "loadCallback", 3, loadCallbackArgs };
+static void loadCallbackCall(const iocshArgBuf *args)
+{
+	loadCallback(args[0].dval, args[1].ival, args[2].dval);
+}
+
+static const iocshArg loadStopArg0 = { "generator", iocshArgString };
+static const iocshArg * const loadStopArgs[] = { &loadStopArg0 };
+static const iocshFuncDef loadStopDef = { "loadStop", 1, loadStopArgs };
+static void loadStopCall(const iocshArgBuf *args)
+{
+	loadStop(args[0].sval);
+}
+
+static const iocshFuncDef loadShowDef = { "loadShow", 0, NULL };
+static void loadShowCall(const iocshArgBuf *args)
+{
+	loadShow();
+}
+
+static void devIocStatsTestRegister(void)
+{
+	iocshRegister(&loadCpuDef, loadCpuCall);
+	iocshRegister(&loadHeapDef, loadHeapCall);
+	iocshRegister(&loadFdDef, loadFdCall);
+	iocshRegister(&loadThreadsDef, loadThreadsCall);
+	iocshRegister(&loadCallbackDef, loadCallbackCall);
+	iocshRegister(&loadStopDef, loadStopCall);
+	iocshRegister(&loadShowDef, loadShowCall);
+}
+epicsExportRegistrar(devIocStatsTestRegister);
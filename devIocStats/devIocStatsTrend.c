@@ -0,0 +1,84 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* devIocStatsTrend.c - Robust growth trend of a statistic over a long
+ *                      sliding window, for leak detection */
+
+/*
+ *  A trend keeps TREND_SAMPLES samples spread over its window (samples
+ *  arriving sooner than window / TREND_SAMPLES after the previous one are
+ *  dropped).  The slope is the Theil-Sen estimator, the median of the
+ *  slopes between all pairs of samples, so single spikes (a large
+ *  temporary buffer, a burst of connections) don't move it.
+ */
+
+#include <stdlib.h>
+
+#include "devIocStats.h"
+
+/* Samples needed before a slope is reported */
+#define TREND_MIN_SAMPLES 10
+
+void devIocStatsTrendInit (trendInfo *pt, double window)
+{
+    pt->window = window > 0 ? window : 86400.0;
+    pt->n = 0;
+    pt->next = 0;
+    pt->slope = 0.0;
+}
+
+static int compareDouble (const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static void trendSlope (trendInfo *pt)
+{
+    double *slopes;
+    int i, j, m = 0;
+
+    slopes = malloc(sizeof(double) * pt->n * (pt->n - 1) / 2);
+    if (!slopes) return;
+    for (i = 0; i < pt->n; i++)
+        for (j = i + 1; j < pt->n; j++)
+            if (pt->time[j] != pt->time[i])
+                slopes[m++] = (pt->value[j] - pt->value[i]) /
+                              (pt->time[j] - pt->time[i]);
+    if (m > 0) {
+        qsort(slopes, m, sizeof(double), compareDouble);
+        pt->slope = m % 2 ? slopes[m / 2] :
+                            (slopes[m / 2 - 1] + slopes[m / 2]) / 2;
+    }
+    free(slopes);
+}
+
+/* Add a sample (time in seconds), returns 1 if it was used */
+int devIocStatsTrendAdd (trendInfo *pt, double time, double value)
+{
+    int last = (pt->next + TREND_SAMPLES - 1) % TREND_SAMPLES;
+
+    if (pt->n > 0 && time - pt->time[last] < pt->window / TREND_SAMPLES)
+        return 0;
+    pt->time[pt->next] = time;
+    pt->value[pt->next] = value;
+    pt->next = (pt->next + 1) % TREND_SAMPLES;
+    if (pt->n < TREND_SAMPLES) pt->n++;
+    if (pt->n >= TREND_MIN_SAMPLES) trendSlope(pt);
+    return 1;
+}
+
+/* Hours until value reaches limit at the current slope, TREND_NEVER if
+   there is no limit, no growth or not enough samples yet */
+double devIocStatsTrendHoursLeft (const trendInfo *pt, double value, double limit)
+{
+    if (limit <= 0 || pt->slope <= 0 || pt->n < TREND_MIN_SAMPLES)
+        return TREND_NEVER;
+    if (value >= limit) return 0.0;
+    value = (limit - value) / pt->slope / 3600.0;
+    return value < TREND_NEVER ? value : TREND_NEVER;
+}
@@ -60,11 +60,41 @@
 		epics_ver		-EPICS base version
                 pwd                     -IOC Current Working Directory
                                         from getcwd
+
+		The top process lists are arrays (one element per process,
+		at most TOP_PROCS) that are updated at the top_scan_rate;
+		use SCAN = "I/O Intr".  The IOC itself is not listed.
+
+		top_cpu_pid	        -pids, sorted by CPU load (FTVL=LONG)
+		top_cpu_comm	        -command names (FTVL=STRING)
+		top_cpu_load	        -percent of one CPU (FTVL=DOUBLE)
+		top_cpu_rss	        -resident memory in bytes (FTVL=DOUBLE)
+		top_mem_pid	        -pids, sorted by RSS (FTVL=LONG)
+		top_mem_comm	        -command names (FTVL=STRING)
+		top_mem_load	        -percent of one CPU (FTVL=DOUBLE)
+		top_mem_rss	        -resident memory in bytes (FTVL=DOUBLE)
+
+		The stalled thread list (at most STALL_THREADS, longest stall
+		first) is updated at the cpu_scan_rate; see stalled_threads.
+
+		stalled_names	        -thread names (FTVL=STRING)
+		stalled_wchan	        -state and kernel wait channel, e.g.
+					"D io_schedule" (FTVL=STRING)
+		stalled_time	        -seconds stalled (FTVL=DOUBLE)
+
+		latency_hist	        -wakeup latency histogram of the
+					latency probe, LATENCY_BUCKETS counts
+					(FTVL=DOUBLE, cpu_scan_rate)
+		latency_edges	        -upper edges (us) of the histogram
+					buckets (FTVL=DOUBLE)
 */
 
 #include <string.h>
+#include <stdlib.h>
 
 #include <epicsVersion.h>
+#include <epicsTypes.h>
+#include <epicsStdio.h>
 #include <dbAccess.h>
 #include <devSup.h>
 #include <waveformRecord.h>
@@ -89,10 +119,12 @@ struct pvtArea
 {
 	int index;
 	int type;
+	int array;
 };
 typedef struct pvtArea pvtArea;
 
 typedef void (*statGetWfmFunc)(char*, size_t);
+typedef epicsUInt32 (*statGetArrFunc)(void*, epicsUInt32);
 
 struct validGetWfmParms
 {
@@ -102,14 +134,38 @@ struct validGetWfmParms
 };
 typedef struct validGetWfmParms validGetWfmParms;
 
+struct validGetArrParms
+{
+	char* name;
+	statGetArrFunc func;
+	int type;
+	int ftvl;
+};
+typedef struct validGetArrParms validGetArrParms;
+
+static long waveform_report(int level);
 static long waveform_init(int pass);
 static long waveform_init_record(waveformRecord*);
 static long waveform_read(waveformRecord*);
+static long waveform_ioint_info(int cmd,waveformRecord* pr,IOSCANPVT* iopvt);
 
 static void statsSScript(char *, size_t);
 static void statsBootline(char *, size_t);
 static void statsPwd(char *, size_t);
 static void statsEPICSVer(char *, size_t);
+static epicsUInt32 statsTopCpuPid(void *, epicsUInt32);
+static epicsUInt32 statsTopCpuComm(void *, epicsUInt32);
+static epicsUInt32 statsTopCpuLoad(void *, epicsUInt32);
+static epicsUInt32 statsTopCpuRss(void *, epicsUInt32);
+static epicsUInt32 statsTopMemPid(void *, epicsUInt32);
+static epicsUInt32 statsTopMemComm(void *, epicsUInt32);
+static epicsUInt32 statsTopMemLoad(void *, epicsUInt32);
+static epicsUInt32 statsTopMemRss(void *, epicsUInt32);
+static epicsUInt32 statsStalledNames(void *, epicsUInt32);
+static epicsUInt32 statsStalledWchan(void *, epicsUInt32);
+static epicsUInt32 statsStalledTime(void *, epicsUInt32);
+static epicsUInt32 statsLatencyHist(void *, epicsUInt32);
+static epicsUInt32 statsLatencyEdges(void *, epicsUInt32);
 
 static validGetWfmParms statsGetWfmParms[]={
 	{ "startup_script",		statsSScript,		STATIC_TYPE },
@@ -119,7 +175,24 @@ static validGetWfmParms statsGetWfmParms[]={
 	{ NULL,NULL,0 }
 };
 
-wStats devWaveformStats  ={5,NULL,waveform_init,waveform_init_record,NULL,waveform_read};
+static validGetArrParms statsGetArrParms[]={
+	{ "top_cpu_pid",		statsTopCpuPid,		TOP_TYPE, menuFtypeLONG },
+	{ "top_cpu_comm",		statsTopCpuComm,	TOP_TYPE, menuFtypeSTRING },
+	{ "top_cpu_load",		statsTopCpuLoad,	TOP_TYPE, menuFtypeDOUBLE },
+	{ "top_cpu_rss",		statsTopCpuRss,		TOP_TYPE, menuFtypeDOUBLE },
+	{ "top_mem_pid",		statsTopMemPid,		TOP_TYPE, menuFtypeLONG },
+	{ "top_mem_comm",		statsTopMemComm,	TOP_TYPE, menuFtypeSTRING },
+	{ "top_mem_load",		statsTopMemLoad,	TOP_TYPE, menuFtypeDOUBLE },
+	{ "top_mem_rss",		statsTopMemRss,		TOP_TYPE, menuFtypeDOUBLE },
+	{ "stalled_names",		statsStalledNames,	LOAD_TYPE, menuFtypeSTRING },
+	{ "stalled_wchan",		statsStalledWchan,	LOAD_TYPE, menuFtypeSTRING },
+	{ "stalled_time",		statsStalledTime,	LOAD_TYPE, menuFtypeDOUBLE },
+	{ "latency_hist",		statsLatencyHist,	LOAD_TYPE, menuFtypeDOUBLE },
+	{ "latency_edges",		statsLatencyEdges,	STATIC_TYPE, menuFtypeDOUBLE },
+	{ NULL,NULL,0,0 }
+};
+
+wStats devWaveformStats  ={5,waveform_report,waveform_init,waveform_init_record,waveform_ioint_info,waveform_read};
 epicsExportAddress(dset,devWaveformStats);
 
 /* ---------------------------------------------------------------------- */
@@ -136,14 +209,9 @@ static long waveform_init(int pass)
 static long waveform_init_record(waveformRecord* pr)
 {
 	int		i;
+	int		ftvl = menuFtypeCHAR;
 	char	*parm;
 	pvtArea	*pvt = NULL;
-	if(pr->ftvl!=menuFtypeCHAR)
-	{
-		recGblRecordError(S_db_badField,(void*)pr,
-			"devWaveformStats (init_record) Illegal FTVL field");
-		return S_db_badField;
-	}
 	if(pr->inp.type!=INST_IO)
 	{
 		recGblRecordError(S_db_badField,(void*)pr,
@@ -158,8 +226,27 @@ static long waveform_init_record(waveformRecord* pr)
 			pvt=(pvtArea*)malloc(sizeof(pvtArea));
 			pvt->index=i;
 			pvt->type=statsGetWfmParms[i].type;
+			pvt->array=0;
 		}
 	}
+	for(i=0;statsGetArrParms[i].name && pvt==NULL;i++)
+	{
+		if(strcmp(parm,statsGetArrParms[i].name)==0)
+		{
+			pvt=(pvtArea*)malloc(sizeof(pvtArea));
+			pvt->index=i;
+			pvt->type=statsGetArrParms[i].type;
+			pvt->array=1;
+			ftvl=statsGetArrParms[i].ftvl;
+		}
+	}
+	if(pvt && pr->ftvl!=ftvl)
+	{
+		free(pvt);
+		recGblRecordError(S_db_badField,(void*)pr,
+			"devWaveformStats (init_record) Illegal FTVL field");
+		return S_db_badField;
+	}
 	if(pvt==NULL)
 	{
 		recGblRecordError(S_db_badField,(void*)pr, 
@@ -172,16 +259,36 @@ static long waveform_init_record(waveformRecord* pr)
 }
 
 
+static long waveform_ioint_info(int cmd,waveformRecord* pr,IOSCANPVT* iopvt)
+{
+	pvtArea* pvt=(pvtArea*)pr->dpvt;
+
+	if (!pvt || !pvt->array) return S_dev_badInpType;
+
+	return devIocStatsIointInfo(pvt->type, cmd, iopvt);
+}
+
+static long waveform_report(int level)
+{
+	devIocStatsShowRead(READ_WAVEFORM);
+	return 0;
+}
+
 static long waveform_read(waveformRecord* pr)
 {
+	double start = devIocStatsClock();
 	pvtArea* pvt=(pvtArea*)pr->dpvt;
 
 	if (!pvt) return S_dev_badInpType;
-	if (pr->nelm > 0) { 
+	if (pvt->array) {
+	  pr->nord = statsGetArrParms[pvt->index].func(pr->bptr, pr->nelm);
+	  pr->udf=0;
+	} else if (pr->nelm > 0) { 
 	  statsGetWfmParms[pvt->index].func((char *)pr->bptr, pr->nelm-1);
 	  pr->nord = strlen((char *)pr->bptr) + 1;
 	  pr->udf=0;
 	}
+	devIocStatsReadTime(READ_WAVEFORM, start);
 	return(0);	/* success */
 }
 
@@ -210,3 +317,108 @@ static void statsEPICSVer(char *d, size_t nelm) {
   strncpy(d, epicsReleaseVersion, nelm);
   d[nelm] = 0;
 }
+
+/* -------------------------------------------------------------------- */
+
+typedef enum { topPid, topComm, topLoad, topRss } topField;
+
+static epicsUInt32 getTopProcs(void *d, epicsUInt32 nelm, int byCpu, topField field)
+{
+    topProcInfo top;
+    procInfo *list;
+    epicsUInt32 i, n;
+
+    devIocStatsReadTopProcs(&top);
+    list = byCpu ? top.byCpu : top.byMem;
+    n = byCpu ? top.nCpu : top.nMem;
+    if (n > nelm) n = nelm;
+
+    for (i = 0; i < n; i++) {
+        switch (field) {
+        case topPid:
+            ((epicsInt32 *)d)[i] = list[i].pid;
+            break;
+        case topComm:
+            strncpy((char *)d + i*MAX_STRING_SIZE, list[i].comm, MAX_STRING_SIZE);
+            ((char *)d)[i*MAX_STRING_SIZE + MAX_STRING_SIZE-1] = 0;
+            break;
+        case topLoad:
+            ((epicsFloat64 *)d)[i] = list[i].cpuLoad;
+            break;
+        case topRss:
+            ((epicsFloat64 *)d)[i] = list[i].rss;
+            break;
+        }
+    }
+    return n;
+}
+
+static epicsUInt32 statsTopCpuPid(void *d, epicsUInt32 nelm)  { return getTopProcs(d, nelm, 1, topPid); }
+static epicsUInt32 statsTopCpuComm(void *d, epicsUInt32 nelm) { return getTopProcs(d, nelm, 1, topComm); }
+static epicsUInt32 statsTopCpuLoad(void *d, epicsUInt32 nelm) { return getTopProcs(d, nelm, 1, topLoad); }
+static epicsUInt32 statsTopCpuRss(void *d, epicsUInt32 nelm)  { return getTopProcs(d, nelm, 1, topRss); }
+
+static epicsUInt32 statsTopMemPid(void *d, epicsUInt32 nelm)  { return getTopProcs(d, nelm, 0, topPid); }
+static epicsUInt32 statsTopMemComm(void *d, epicsUInt32 nelm) { return getTopProcs(d, nelm, 0, topComm); }
+static epicsUInt32 statsTopMemLoad(void *d, epicsUInt32 nelm) { return getTopProcs(d, nelm, 0, topLoad); }
+static epicsUInt32 statsTopMemRss(void *d, epicsUInt32 nelm)  { return getTopProcs(d, nelm, 0, topRss); }
+
+/* -------------------------------------------------------------------- */
+
+typedef enum { stallName, stallWchan, stallTime } stallField;
+
+static epicsUInt32 getStalls(void *d, epicsUInt32 nelm, stallField field)
+{
+    stallInfo stalls;
+    char *str;
+    epicsUInt32 i, n;
+
+    devIocStatsReadStalls(&stalls);
+    n = stalls.nList;
+    if (n > nelm) n = nelm;
+
+    for (i = 0; i < n; i++) {
+        str = (char *)d + i*MAX_STRING_SIZE;
+        switch (field) {
+        case stallName:
+            strncpy(str, stalls.list[i].name, MAX_STRING_SIZE);
+            str[MAX_STRING_SIZE-1] = 0;
+            break;
+        case stallWchan:
+            epicsSnprintf(str, MAX_STRING_SIZE, "%c %s",
+                          stalls.list[i].state, stalls.list[i].wchan);
+            break;
+        case stallTime:
+            ((epicsFloat64 *)d)[i] = stalls.list[i].seconds;
+            break;
+        }
+    }
+    return n;
+}
+
+static epicsUInt32 statsStalledNames(void *d, epicsUInt32 nelm) { return getStalls(d, nelm, stallName); }
+static epicsUInt32 statsStalledWchan(void *d, epicsUInt32 nelm) { return getStalls(d, nelm, stallWchan); }
+static epicsUInt32 statsStalledTime(void *d, epicsUInt32 nelm)  { return getStalls(d, nelm, stallTime); }
+
+/* -------------------------------------------------------------------- */
+
+static epicsUInt32 statsLatencyHist(void *d, epicsUInt32 nelm)
+{
+    latencyInfo l;
+    epicsUInt32 i, n = nelm < LATENCY_BUCKETS ? nelm : LATENCY_BUCKETS;
+
+    devIocStatsReadLatency(&l);
+    for (i = 0; i < n; i++)
+        ((epicsFloat64 *)d)[i] = l.hist[i];
+    return n;
+}
+
+static epicsUInt32 statsLatencyEdges(void *d, epicsUInt32 nelm)
+{
+    epicsUInt32 i, n = nelm < LATENCY_BUCKETS ? nelm : LATENCY_BUCKETS;
+    double edge = 2.0;
+
+    for (i = 0; i < n; i++, edge *= 2)
+        ((epicsFloat64 *)d)[i] = edge;
+    return n;
+}
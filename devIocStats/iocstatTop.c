@@ -0,0 +1,201 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* iocstatTop.c - iocstat-top: show the shared memory statistics segments
+ *                of all IOCs on the host (see devIocStatsShm.h) */
+
+/*
+ *  Usage: iocstat-top [-b] [-d <delay>] [-n <iterations>] [-s <sort>]
+ *      -b  batch mode, do not clear the screen between updates
+ *      -d  seconds between updates (default 2)
+ *      -n  number of updates, 0 = forever (default)
+ *      -s  sort by cpu (default), mem, fd, ca, late or pid
+ *
+ *  The IOCs must be started with
+ *      var devIocStatsShm 1
+ *  Segments of IOCs that have exited without cleaning up are skipped.
+ */
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "devIocStatsShm.h"
+
+#define SHM_DIR     "/dev/shm"
+#define MAX_IOCS    1024
+#define MAX_RETRIES 100
+
+#if defined(__GNUC__)
+#define MEMORY_BARRIER() __sync_synchronize()
+#else
+#define MEMORY_BARRIER()
+#endif
+
+static iocStatsShm iocs[MAX_IOCS];
+static char sortKey = 'c';
+
+/* Consistent copy of one segment, returns 0 on success */
+static int readSegment (const char *name, iocStatsShm *pval)
+{
+    const volatile iocStatsShm *pshm;
+    struct stat st;
+    unsigned int seq;
+    size_t size;
+    void *addr;
+    int fd, i, ret = -1;
+
+    fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return -1;
+    /* Created with size 0 and grown by ftruncate(): reading pages past
+       the end of a segment that is not grown yet raises SIGBUS */
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(iocStatsShm)) {
+        close(fd);
+        return -1;
+    }
+    addr = mmap(NULL, sizeof(iocStatsShm), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) return -1;
+    pshm = (const volatile iocStatsShm *)addr;
+
+    if (pshm->magic == IOCSTATS_SHM_MAGIC &&
+        pshm->version == IOCSTATS_SHM_VERSION) {
+        /* Writers of a later version may have appended fields */
+        size = pshm->size < sizeof(iocStatsShm) ? pshm->size : sizeof(iocStatsShm);
+        if (size > (size_t)st.st_size) size = st.st_size;
+        memset(pval, 0, sizeof(*pval));
+        for (i = 0; i < MAX_RETRIES; i++) {
+            seq = pshm->seq;
+            if (seq & 1) {
+                usleep(100);
+                continue;
+            }
+            MEMORY_BARRIER();
+            memcpy(pval, (const void *)pshm, size);
+            MEMORY_BARRIER();
+            if (pshm->seq == seq) {
+                ret = 0;
+                break;
+            }
+        }
+    }
+    munmap(addr, sizeof(iocStatsShm));
+    return ret;
+}
+
+static int compare (const void *a, const void *b)
+{
+    const iocStatsShm *pa = a, *pb = b;
+    double va, vb;
+
+    switch (sortKey) {
+    case 'm': va = pa->memAlloc;     vb = pb->memAlloc;     break;
+    case 'f': va = pa->fdUsed;       vb = pb->fdUsed;       break;
+    case 'a': va = pa->caClients;    vb = pb->caClients;    break;
+    case 'l': va = pa->scanLateness; vb = pb->scanLateness; break;
+    case 'p': return pa->pid - pb->pid;
+    default:  va = pa->iocCpuLoad;   vb = pb->iocCpuLoad;   break;
+    }
+    return (va < vb) - (va > vb);
+}
+
+static int collect (void)
+{
+    DIR *pdir;
+    struct dirent *pdit;
+    char name[280];
+    int prefixLen = strlen(IOCSTATS_SHM_PREFIX) - 1;
+    int n = 0;
+
+    if ((pdir = opendir(SHM_DIR)) == NULL) return 0;
+    while (n < MAX_IOCS && (pdit = readdir(pdir)) != NULL) {
+        /* Segment names without the leading '/' */
+        if (strncmp(pdit->d_name, IOCSTATS_SHM_PREFIX + 1, prefixLen) != 0)
+            continue;
+        sprintf(name, "/%.270s", pdit->d_name);
+        if (readSegment(name, &iocs[n])) continue;
+        if (kill(iocs[n].pid, 0) < 0 && errno == ESRCH) continue;
+        n++;
+    }
+    closedir(pdir);
+    qsort(iocs, n, sizeof(iocStatsShm), compare);
+    return n;
+}
+
+static void show (int n)
+{
+    struct timeval tv;
+    double now;
+    char fds[24];
+    int i;
+
+    gettimeofday(&tv, NULL);
+    now = tv.tv_sec + tv.tv_usec / 1e6;
+
+    printf("%d IOCs\n\n", n);
+    printf("%7s %-20s %6s %6s %9s %11s %6s %7s %8s %5s\n",
+           "PID", "IOC", "CPU%", "SYS%", "MEM(MB)", "FD/MAX",
+           "CA_CLI", "CA_CONN", "LATE(ms)", "AGE");
+    for (i = 0; i < n; i++) {
+        iocStatsShm *p = &iocs[i];
+        sprintf(fds, "%.0f/%.0f", p->fdUsed, p->fdMax);
+        printf("%7d %-20.20s %6.1f %6.1f %9.1f %11s %6.0f %7.0f %8.1f %5.0f\n",
+               p->pid, p->name[0] ? p->name : "-",
+               p->iocCpuLoad, p->sysCpuLoad, p->memAlloc / 1048576.0, fds,
+               p->caClients, p->caConnections, p->scanLateness * 1e3,
+               now - p->updateTime);
+    }
+}
+
+static void usage (const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-b] [-d <delay>] [-n <iterations>] "
+            "[-s cpu|mem|fd|ca|late|pid]\n", prog);
+    exit(1);
+}
+
+int main (int argc, char *argv[])
+{
+    double delay = 2.0;
+    int iterations = 0, batch = 0;
+    int opt, i;
+
+    while ((opt = getopt(argc, argv, "bd:n:s:h")) != -1) {
+        switch (opt) {
+        case 'b': batch = 1; break;
+        case 'd': delay = atof(optarg); break;
+        case 'n': iterations = atoi(optarg); break;
+        case 's':
+            if (strcmp(optarg, "ca") == 0) sortKey = 'a';
+            else if (strchr("cmflp", optarg[0])) sortKey = optarg[0];
+            else usage(argv[0]);
+            break;
+        default: usage(argv[0]);
+        }
+    }
+    if (delay <= 0) delay = 2.0;
+    if (!isatty(STDOUT_FILENO)) batch = 1;
+
+    for (i = 0; iterations == 0 || i < iterations; i++) {
+        int n = collect();
+        if (!batch) printf("\033[H\033[J");
+        else if (i) printf("\n");
+        show(n);
+        fflush(stdout);
+        if (iterations == 0 || i + 1 < iterations)
+            usleep((useconds_t)(delay * 1e6));
+    }
+    return 0;
+}
@@ -28,13 +28,13 @@ static epicsTimeStamp oldTime;
 static double oldUsage;
 
 static double cpuFromProc (void) {
-    static char statfile[] = "/proc/stat";
+    char statfile[256];
     long user = 0;
     long nice = 0;
     long sys = 0;
     FILE *fp;
 
-    fp = fopen(statfile, "r");
+    fp = fopen(devIocStatsProcPath(statfile, sizeof(statfile), "/proc/stat"), "r");
     if (fp) {
         fscanf(fp, "cpu %lu %lu %lu", &user, &nice, &sys);
         fclose(fp);
@@ -43,7 +43,7 @@ static double cpuFromProc (void) {
 }
 
 int devIocStatsInitCpuUsage (void) {
-    epicsTimeGetCurrent(&oldTime);
+    devIocStatsGetTime(&oldTime);
     oldUsage = cpuFromProc();
     return 0;
 }
@@ -54,11 +54,11 @@ int devIocStatsGetCpuUsage (loadInfo *pval) {
     double elapsed;
     double cpuFract;
 
-    epicsTimeGetCurrent(&curTime);
+    devIocStatsGetTime(&curTime);
     curUsage = cpuFromProc();
     elapsed = epicsTimeDiffInSeconds(&curTime, &oldTime);
 
-    cpuFract = (elapsed > 0) ? 100 * (curUsage - oldUsage) / (elapsed * NO_OF_CPUS): 0.0;
+    cpuFract = (elapsed > 0) ? 100 * (curUsage - oldUsage) / (elapsed * devIocStatsNoOfCpus()): 0.0;
 
     oldTime = curTime;
     oldUsage = curUsage;
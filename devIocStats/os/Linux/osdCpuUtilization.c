@@ -10,7 +10,8 @@
 * in file LICENSE that is included with this distribution.
 \*************************************************************************/
 
-/* osdCpuUtilization.c - CPU utilization info: linux implementation = read /proc/self/stat */
+/* osdCpuUtilization.c - CPU utilization info: linux implementation = use the
+ *                        process CPU-time clock, /proc/self/stat as fallback */
 
 /*
  *  Author: Ralph Lange (HZB/BESSY)
@@ -19,18 +20,22 @@
  *
  */
 
+#include <sys/types.h>
+#include <dirent.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <time.h>
 
 #include <epicsTime.h>
 #include <devIocStats.h>
 
 static epicsTimeStamp oldTime;
 static double oldUsage;
+static double oldWait;
 static double scale;
 
 static double usageFromProc (void) {
-    static char statfile[] = "/proc/self/stat";
+    char statfile[256];
     char sd[80];
     char cd;
     int id;
@@ -40,7 +45,7 @@ static double usageFromProc (void) {
     long uticks = 0;
     FILE *fp;
 
-    fp = fopen(statfile, "r");
+    fp = fopen(devIocStatsProcPath(statfile, sizeof(statfile), "/proc/self/stat"), "r");
     if (fp) {
         fscanf(fp, "%d %s %c %d %d %d %d %d %u %lu %lu %lu %lu %lu %lu",
                &id, sd, &cd, &id, &id, &id, &id, &id, &ud, &ld, &ld, &ld, &ld, &uticks, &sticks );
@@ -49,11 +54,46 @@ static double usageFromProc (void) {
     return (uticks + sticks) / (double)TICKS_PER_SEC;
 }
 
+/* ns resolution, where /proc/self/stat only has clock ticks */
+static double usageFromClock (void) {
+    struct timespec ts;
+
+    if (devIocStatsReplaying() || clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts))
+        return usageFromProc();
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Sum of the time (sec) all live threads spent runnable but not running */
+static double waitFromSchedstat (void) {
+    char taskdir[256];
+    char path[300];
+    unsigned long long run, wait;
+    double total = 0.0;
+    DIR *pdir;
+    struct dirent *pdit;
+    FILE *fp;
+
+    devIocStatsProcPath(taskdir, sizeof(taskdir), "/proc/self/task");
+    if ((pdir = opendir(taskdir)) == NULL) return 0.0;
+    while ((pdit = readdir(pdir)) != NULL) {
+        if (pdit->d_name[0] == '.') continue;
+        sprintf(path, "%s/%.16s/schedstat", taskdir, pdit->d_name);
+        fp = fopen(path, "r");
+        if (!fp) continue;
+        if (fscanf(fp, "%llu %llu", &run, &wait) == 2)
+            total += wait / 1e9;
+        fclose(fp);
+    }
+    closedir(pdir);
+    return total;
+}
+
 int devIocStatsInitCpuUtilization (loadInfo *pval) {
-    epicsTimeGetCurrent(&oldTime);
-    oldUsage = usageFromProc();
-    scale = 100.0f / NO_OF_CPUS;
-    pval->noOfCpus = NO_OF_CPUS;
+    devIocStatsGetTime(&oldTime);
+    oldUsage = usageFromClock();
+    oldWait = waitFromSchedstat();
+    pval->noOfCpus = devIocStatsNoOfCpus();
+    scale = 100.0f / pval->noOfCpus;
     return 0;
 }
 
@@ -61,18 +101,26 @@ int devIocStatsGetCpuUtilization (loadInfo *pval)
 {
     epicsTimeStamp curTime;
     double curUsage;
+    double curWait;
     double elapsed;
     double cpuFract;
+    double waitRate;
 
-    epicsTimeGetCurrent(&curTime);
-    curUsage = usageFromProc();
+    devIocStatsGetTime(&curTime);
+    curUsage = usageFromClock();
+    curWait = waitFromSchedstat();
     elapsed = epicsTimeDiffInSeconds(&curTime, &oldTime);
 
     cpuFract = (elapsed > 0) ? (curUsage - oldUsage) * scale / elapsed : 0.0;
+    /* Threads that exited take their wait time with them */
+    waitRate = (elapsed > 0 && curWait > oldWait) ?
+               1000.0 * (curWait - oldWait) / elapsed : 0.0;
 
     oldTime = curTime;
     oldUsage = curUsage;
+    oldWait = curWait;
 
     pval->iocLoad = cpuFract;
+    pval->iocRunqWait = waitRate;
     return 0;
 }
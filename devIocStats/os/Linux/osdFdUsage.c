@@ -30,16 +30,18 @@ int devIocStatsInitFDUsage (void) { return 0; }
 
 int devIocStatsGetFDUsage (fdInfo *pval)
 {
-    static char fddir[]="/proc/self/fd";
+    char fddir[256];
     DIR *pdir;
     struct dirent *pdit;
     struct rlimit lim;
     int i = 0;
 
+    devIocStatsProcPath(fddir, sizeof(fddir), "/proc/self/fd");
     if ((pdir = opendir(fddir)) == NULL) return -1;
     while ((pdit = readdir(pdir)) != NULL) i++;
     if (closedir(pdir) == -1) return -1;
-    pval->used = i - 3; /* Don't count this operation, '.' and '..' */
+    /* Don't count this operation (not in a snapshot), '.' and '..' */
+    pval->used = i - (devIocStatsReplaying() ? 2 : 3);
 
     if (getrlimit(RLIMIT_NOFILE, &lim)) return -1;
     pval->max = lim.rlim_cur;
@@ -0,0 +1,322 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* osdIOUsage.c - Process I/O and delay accounting: Linux implementation =
+ *                use /proc/self/io and taskstats over generic netlink */
+
+/*
+ *  The /proc/self/io counters are always used.  The delay accounting
+ *  totals (run queue, block I/O, swap-in) are fetched through the
+ *  TASKSTATS generic netlink family, which needs CONFIG_TASK_DELAY_ACCT,
+ *  delay accounting switched on (delayacct boot option or the
+ *  kernel.task_delayacct sysctl) and usually CAP_NET_ADMIN.  If taskstats
+ *  is not usable, the block I/O delay falls back to the aggregated
+ *  delayacct_blkio_ticks field of /proc/self/stat and the other two delays
+ *  read as 0.  A delay whose source changed since the last sample reads
+ *  as 0 for that sample, as the two sources count differently.
+ *
+ *  The netlink reply is waited for 10 ms at most, as this runs on the
+ *  shared timer queue thread.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+#include <linux/taskstats.h>
+
+#include <epicsTime.h>
+#include <devIocStats.h>
+
+#define NLA_DATA(na)    ((void *)((char *)(na) + NLA_HDRLEN))
+#define NLA_NEXT(na)    ((struct nlattr *)((char *)(na) + NLA_ALIGN((na)->nla_len)))
+#define NLA_OK(na,len)  ((len) >= (int)sizeof(struct nlattr) && \
+                         (na)->nla_len >= sizeof(struct nlattr) && \
+                         (na)->nla_len <= (len))
+#define GENL_MSG_DATA(nh) ((struct nlattr *)((char *)NLMSG_DATA(nh) + GENL_HDRLEN))
+#define GENL_MSG_LEN(nh)  ((int)(nh)->nlmsg_len - NLMSG_HDRLEN - GENL_HDRLEN)
+
+/* Where a delay counter came from */
+#define DELAY_NONE      0
+#define DELAY_TASKSTATS 1
+#define DELAY_PROC      2
+
+typedef struct {
+    double rchar;
+    double wchar;
+    double syscr;
+    double syscw;
+    double read_bytes;
+    double write_bytes;
+    double cpu_delay;       /* ns */
+    double blkio_delay;     /* ns */
+    double swapin_delay;    /* ns */
+    int cpu_src;
+    int blkio_src;
+    int swapin_src;
+} ioCounters;
+
+struct genlRequest {
+    struct nlmsghdr n;
+    struct genlmsghdr g;
+    char buf[256];
+};
+
+static epicsTimeStamp oldTime;
+static ioCounters oldCounters;
+static int nlSock = -1;
+static int nlFamily = 0;
+static __u32 nlSeq = 0;
+
+/* ---------------------------------------------------------------------- */
+
+static int nlSend (__u16 type, __u8 cmd, __u16 attr, const void *data, int len)
+{
+    struct genlRequest req;
+    struct nlattr *na;
+    struct sockaddr_nl addr;
+
+    memset(&req, 0, sizeof(req));
+    req.n.nlmsg_len   = NLMSG_LENGTH(GENL_HDRLEN);
+    req.n.nlmsg_type  = type;
+    req.n.nlmsg_flags = NLM_F_REQUEST;
+    req.n.nlmsg_seq   = ++nlSeq;
+    req.n.nlmsg_pid   = 0;
+    req.g.cmd         = cmd;
+    req.g.version     = (type == GENL_ID_CTRL) ? 1 : TASKSTATS_GENL_VERSION;
+
+    na = (struct nlattr *)((char *)&req + NLMSG_ALIGN(req.n.nlmsg_len));
+    na->nla_type = attr;
+    na->nla_len  = NLA_HDRLEN + len;
+    memcpy(NLA_DATA(na), data, len);
+    req.n.nlmsg_len += NLA_ALIGN(na->nla_len);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    if (sendto(nlSock, &req, req.n.nlmsg_len, 0,
+               (struct sockaddr *)&addr, sizeof(addr)) < 0)
+        return -1;
+    return 0;
+}
+
+/* Receive the reply to the last request, returns its length or -1 */
+static int nlRecv (char *buf, int size)
+{
+    struct nlmsghdr *nh = (struct nlmsghdr *)buf;
+    int len;
+
+    do {
+        len = recv(nlSock, buf, size, 0);
+        if (len < 0 || !NLMSG_OK(nh, (unsigned)len)) return -1;
+    } while (nh->nlmsg_seq != nlSeq);
+
+    if (nh->nlmsg_type == NLMSG_ERROR) {
+        struct nlmsgerr *err = (struct nlmsgerr *)NLMSG_DATA(nh);
+        errno = -err->error;
+        return -1;
+    }
+    return len;
+}
+
+static void nlClose (void)
+{
+    if (nlSock >= 0) close(nlSock);
+    nlSock = -1;
+    nlFamily = 0;
+}
+
+static void nlOpen (void)
+{
+    struct sockaddr_nl addr;
+    struct timeval tmo = { 0, 10000 };
+    char buf[1024];
+    struct nlmsghdr *nh = (struct nlmsghdr *)buf;
+    struct nlattr *na;
+    int len;
+
+    if (nlSock >= 0) return;
+    nlSock = socket(AF_NETLINK, SOCK_RAW, NETLINK_GENERIC);
+    if (nlSock < 0) return;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    if (bind(nlSock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        setsockopt(nlSock, SOL_SOCKET, SO_RCVTIMEO, &tmo, sizeof(tmo)) < 0) {
+        nlClose();
+        return;
+    }
+
+    /* Resolve the TASKSTATS family id */
+    if (nlSend(GENL_ID_CTRL, CTRL_CMD_GETFAMILY, CTRL_ATTR_FAMILY_NAME,
+               TASKSTATS_GENL_NAME, strlen(TASKSTATS_GENL_NAME) + 1) ||
+        (len = nlRecv(buf, sizeof(buf))) < 0) {
+        nlClose();
+        return;
+    }
+    len = GENL_MSG_LEN(nh);
+    for (na = GENL_MSG_DATA(nh); NLA_OK(na, len); na = NLA_NEXT(na)) {
+        len -= NLA_ALIGN(na->nla_len);
+        if (na->nla_type == CTRL_ATTR_FAMILY_ID) {
+            nlFamily = *(__u16 *)NLA_DATA(na);
+            break;
+        }
+    }
+    if (!nlFamily) nlClose();
+}
+
+/* Fetch the delay totals for the whole thread group */
+static int delayFromTaskstats (ioCounters *pc)
+{
+    char buf[1024];
+    struct nlmsghdr *nh = (struct nlmsghdr *)buf;
+    struct nlattr *na, *nested;
+    struct taskstats ts;
+    __u32 tgid = getpid();
+    int len, nlen;
+
+    if (nlSock < 0) return -1;
+
+    if (nlSend(nlFamily, TASKSTATS_CMD_GET, TASKSTATS_CMD_ATTR_TGID,
+               &tgid, sizeof(tgid)) ||
+        nlRecv(buf, sizeof(buf)) < 0) {
+        /* Permission or configuration problems do not go away */
+        if (errno == EPERM || errno == EACCES || errno == EINVAL ||
+            errno == EOPNOTSUPP)
+            nlClose();
+        return -1;
+    }
+
+    len = GENL_MSG_LEN(nh);
+    for (na = GENL_MSG_DATA(nh); NLA_OK(na, len); na = NLA_NEXT(na)) {
+        len -= NLA_ALIGN(na->nla_len);
+        if (na->nla_type != TASKSTATS_TYPE_AGGR_TGID) continue;
+        nlen = na->nla_len - NLA_HDRLEN;
+        for (nested = NLA_DATA(na); NLA_OK(nested, nlen); nested = NLA_NEXT(nested)) {
+            nlen -= NLA_ALIGN(nested->nla_len);
+            if (nested->nla_type != TASKSTATS_TYPE_STATS) continue;
+            /* Older kernels send a shorter struct */
+            memset(&ts, 0, sizeof(ts));
+            memcpy(&ts, NLA_DATA(nested),
+                   nested->nla_len - NLA_HDRLEN < sizeof(ts) ?
+                   nested->nla_len - NLA_HDRLEN : sizeof(ts));
+            pc->cpu_delay    = (double)ts.cpu_delay_total;
+            pc->blkio_delay  = (double)ts.blkio_delay_total;
+            pc->swapin_delay = (double)ts.swapin_delay_total;
+            pc->cpu_src = pc->blkio_src = pc->swapin_src = DELAY_TASKSTATS;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/* Block I/O delay only, from field 42 (delayacct_blkio_ticks) */
+static void delayFromProc (ioCounters *pc)
+{
+    char statfile[256];
+    char buf[1024];
+    char *p;
+    unsigned long long ticks;
+    int field;
+    FILE *fp;
+
+    fp = fopen(devIocStatsProcPath(statfile, sizeof(statfile), "/proc/self/stat"), "r");
+    if (!fp) return;
+    p = fgets(buf, sizeof(buf), fp);
+    fclose(fp);
+    if (!p || !(p = strrchr(buf, ')'))) return;
+
+    /* Field 3 (state) follows the command name */
+    for (field = 2; field < 42 && p; field++)
+        p = strchr(p + 1, ' ');
+    if (p && sscanf(p, " %llu", &ticks) == 1) {
+        pc->blkio_delay = ticks * 1e9 / TICKS_PER_SEC;
+        pc->blkio_src = DELAY_PROC;
+    }
+}
+
+static void countersFromProc (ioCounters *pc)
+{
+    char iofile[256];
+    char title[32];
+    unsigned long long value;
+    FILE *fp;
+
+    memset(pc, 0, sizeof(*pc));
+
+    fp = fopen(devIocStatsProcPath(iofile, sizeof(iofile), "/proc/self/io"), "r");
+    if (fp) {
+        while (fscanf(fp, "%31s %llu", title, &value) == 2) {
+            if      (strcmp(title, "rchar:") == 0)       pc->rchar       = value;
+            else if (strcmp(title, "wchar:") == 0)       pc->wchar       = value;
+            else if (strcmp(title, "syscr:") == 0)       pc->syscr       = value;
+            else if (strcmp(title, "syscw:") == 0)       pc->syscw       = value;
+            else if (strcmp(title, "read_bytes:") == 0)  pc->read_bytes  = value;
+            else if (strcmp(title, "write_bytes:") == 0) pc->write_bytes = value;
+        }
+        fclose(fp);
+    }
+
+    /* Taskstats would report on the live process */
+    if (devIocStatsReplaying() || delayFromTaskstats(pc)) delayFromProc(pc);
+}
+
+/* Counters only move forward; a negative step means the source changed */
+static double rate (double cur, double old, double elapsed)
+{
+    return (cur > old) ? (cur - old) / elapsed : 0.0;
+}
+
+/* No rate across a change of source */
+static double delayRate (double cur, int curSrc, double old, int oldSrc,
+                         double elapsed)
+{
+    return (curSrc == oldSrc) ? rate(cur, old, elapsed) : 0.0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+int devIocStatsInitIOUsage (void) {
+    nlOpen();
+    devIocStatsGetTime(&oldTime);
+    countersFromProc(&oldCounters);
+    return 0;
+}
+
+int devIocStatsGetIOUsage (ioInfo *pval)
+{
+    epicsTimeStamp curTime;
+    ioCounters cur;
+    double elapsed;
+
+    devIocStatsGetTime(&curTime);
+    countersFromProc(&cur);
+    elapsed = epicsTimeDiffInSeconds(&curTime, &oldTime);
+
+    if (elapsed > 0) {
+        pval->readBytes      = rate(cur.rchar,       oldCounters.rchar,       elapsed);
+        pval->writeBytes     = rate(cur.wchar,       oldCounters.wchar,       elapsed);
+        pval->readCalls      = rate(cur.syscr,       oldCounters.syscr,       elapsed);
+        pval->writeCalls     = rate(cur.syscw,       oldCounters.syscw,       elapsed);
+        pval->diskReadBytes  = rate(cur.read_bytes,  oldCounters.read_bytes,  elapsed);
+        pval->diskWriteBytes = rate(cur.write_bytes, oldCounters.write_bytes, elapsed);
+        /* ns per second -> ms per second */
+        pval->cpuDelay       = delayRate(cur.cpu_delay,    cur.cpu_src,
+                                         oldCounters.cpu_delay,    oldCounters.cpu_src,    elapsed) / 1e6;
+        pval->blkioDelay     = delayRate(cur.blkio_delay,  cur.blkio_src,
+                                         oldCounters.blkio_delay,  oldCounters.blkio_src,  elapsed) / 1e6;
+        pval->swapinDelay    = delayRate(cur.swapin_delay, cur.swapin_src,
+                                         oldCounters.swapin_delay, oldCounters.swapin_src, elapsed) / 1e6;
+    }
+
+    oldTime = curTime;
+    oldCounters = cur;
+    return 0;
+}
@@ -0,0 +1,95 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* osdLimits.c - Thread count and resource limits: Linux implementation =
+ *               use /proc/self/status, getrlimit() and the cgroup */
+
+/*
+ *  The memory limit is the one of the IOC's cgroup (memory.max with
+ *  cgroup v2, memory.limit_in_bytes with v1), else RLIMIT_AS.  A cgroup
+ *  limit applies to all processes of the group including their page
+ *  cache, so it is an upper bound for the IOC alone.  With neither it is
+ *  the physical memory, which does not depend on reading /proc/meminfo
+ *  (not done with devIocStatsHostStats 0).
+ */
+
+#include <sys/resource.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <devIocStats.h>
+
+static char memLimitFile[256] = "";
+
+int devIocStatsInitLimits (void)
+{
+    char cgfile[256];
+    char line[256];
+    char *path;
+    FILE *fp;
+
+    memLimitFile[0] = '\0';
+    fp = fopen(devIocStatsProcPath(cgfile, sizeof(cgfile), "/proc/self/cgroup"), "r");
+    if (!fp) return 0;
+    /* "0::<path>" (v2) or "<n>:...memory...:<path>" (v1) */
+    while (fgets(line, sizeof(line), fp)) {
+        line[strcspn(line, "\n")] = '\0';
+        path = strrchr(line, ':');
+        if (!path) continue;
+        if (strncmp(line, "0::", 3) == 0) {
+            if (!memLimitFile[0])
+                sprintf(memLimitFile, "/sys/fs/cgroup%.200s/memory.max",
+                        strcmp(path + 1, "/") ? path + 1 : "");
+        } else if (strstr(line, ":memory:") || strstr(line, ",memory")) {
+            sprintf(memLimitFile, "/sys/fs/cgroup/memory%.200s/memory.limit_in_bytes",
+                    strcmp(path + 1, "/") ? path + 1 : "");
+            break;
+        }
+    }
+    fclose(fp);
+    return 0;
+}
+
+int devIocStatsGetMemLimit (double *pval)
+{
+    struct rlimit lim;
+    double limit = 0.0;
+    FILE *fp;
+
+    if (memLimitFile[0] && (fp = fopen(memLimitFile, "r"))) {
+        /* "max" or a huge number if unlimited */
+        if (fscanf(fp, "%lf", &limit) != 1 || limit >= 1e18) limit = 0.0;
+        fclose(fp);
+    }
+    if (limit == 0.0 && getrlimit(RLIMIT_AS, &lim) == 0 &&
+        lim.rlim_cur != RLIM_INFINITY)
+        limit = (double)lim.rlim_cur;
+    if (limit == 0.0)
+        limit = (double)sysconf(_SC_PHYS_PAGES) * (double)sysconf(_SC_PAGESIZE);
+    *pval = limit;
+    return 0;
+}
+
+int devIocStatsGetLimits (limitInfo *pval)
+{
+    char statusfile[256];
+    char line[256];
+    struct rlimit lim;
+    FILE *fp;
+
+    pval->threads = 0;
+    fp = fopen(devIocStatsProcPath(statusfile, sizeof(statusfile), "/proc/self/status"), "r");
+    if (!fp) return -1;
+    while (fgets(line, sizeof(line), fp))
+        if (sscanf(line, "Threads: %d", &pval->threads) == 1) break;
+    fclose(fp);
+
+    pval->threadLimit = 0.0;
+    if (getrlimit(RLIMIT_NPROC, &lim) == 0 && lim.rlim_cur != RLIM_INFINITY)
+        pval->threadLimit = (double)lim.rlim_cur;
+    return 0;
+}
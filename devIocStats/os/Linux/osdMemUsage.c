@@ -36,8 +36,8 @@ int devIocStatsInitMemUsage (void) {
 
 int devIocStatsGetMemUsage (memInfo *pval)
 {
-    static char statmfile[] = "/proc/self/statm";
-    static char memfile[]   = "/proc/meminfo";
+    char statmfile[256];
+    char memfile[256];
     unsigned long size, resident, value, total = 0, memfree = 0;
     char title[32] = "";
     char units[32] = "";
@@ -45,13 +45,13 @@ int devIocStatsGetMemUsage (memInfo *pval)
     int found = 0;
     FILE *fp;
 
-    fp = fopen(statmfile, "r");
+    fp = fopen(devIocStatsProcPath(statmfile, sizeof(statmfile), "/proc/self/statm"), "r");
     if (fp) {
         fscanf(fp, "%lu %lu", &size, &resident);
         fclose(fp);
     }
 
-    fp = fopen(memfile, "r");
+    fp = devIocStatsHostStats ? fopen(devIocStatsProcPath(memfile, sizeof(memfile), "/proc/meminfo"), "r") : NULL;
     if (fp) {
         while (ret != EOF && found < 4) {
             ret = fscanf(fp, "%31s %lu %s\n", title, &value, units);
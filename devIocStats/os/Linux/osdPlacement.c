@@ -0,0 +1,83 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* osdPlacement.c - CPU affinity and scheduling policy of a thread:
+ *                  Linux implementation = use sched_setaffinity() and
+ *                  sched_setscheduler(), which take thread ids */
+
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <devIocStats.h>
+
+/* "0-3,6" */
+static int parseCpus (const char *cpus, cpu_set_t *set)
+{
+    const char *p = cpus;
+    char *end;
+    long first, last, cpu;
+
+    CPU_ZERO(set);
+    while (*p) {
+        first = last = strtol(p, &end, 10);
+        if (end == p || first < 0) return -1;
+        p = end;
+        if (*p == '-') {
+            last = strtol(++p, &end, 10);
+            if (end == p || last < first) return -1;
+            p = end;
+        }
+        for (cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+            CPU_SET(cpu, set);
+        if (*p == ',') p++;
+        else if (*p) return -1;
+    }
+    return CPU_COUNT(set) ? 0 : -1;
+}
+
+static int parsePolicy (const char *name)
+{
+    if (strcmp(name, "OTHER") == 0) return SCHED_OTHER;
+    if (strcmp(name, "FIFO") == 0) return SCHED_FIFO;
+    if (strcmp(name, "RR") == 0) return SCHED_RR;
+#ifdef SCHED_BATCH
+    if (strcmp(name, "BATCH") == 0) return SCHED_BATCH;
+#endif
+#ifdef SCHED_IDLE
+    if (strcmp(name, "IDLE") == 0) return SCHED_IDLE;
+#endif
+    return -1;
+}
+
+int devIocStatsCheckPlacement (const char *cpus, const char *policy)
+{
+    cpu_set_t set;
+
+    if (cpus && *cpus && parseCpus(cpus, &set)) return -1;
+    if (policy && *policy && parsePolicy(policy) < 0) return -1;
+    return 0;
+}
+
+int devIocStatsPlaceThread (int tid, const char *cpus, const char *policy,
+                            int priority)
+{
+    struct sched_param param;
+    cpu_set_t set;
+    int pol, status = 0;
+
+    if (cpus && *cpus) {
+        if (parseCpus(cpus, &set) || sched_setaffinity(tid, sizeof(set), &set))
+            status = -1;
+    }
+    if (policy && *policy) {
+        if ((pol = parsePolicy(policy)) < 0) return -1;
+        memset(&param, 0, sizeof(param));
+        if (pol == SCHED_FIFO || pol == SCHED_RR) param.sched_priority = priority;
+        if (sched_setscheduler(tid, pol, &param)) status = -1;
+    }
+    return status;
+}
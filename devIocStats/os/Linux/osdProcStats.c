@@ -0,0 +1,271 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* osdProcStats.c - Processes of other IOCs: Linux implementation = use /proc/<pid> */
+
+/*
+ *  A process is considered an IOC if its command name or the base name of
+ *  argv[0] matches the given glob pattern or, without a pattern, if it has
+ *  the EPICS database library (libdbCore, libdbIoc for 3.14) mapped.  The
+ *  result of the maps check is remembered per pid and start time, so only
+ *  new processes are examined.
+ *
+ *  The IOC name is the IOC environment variable from the initial
+ *  environment, else the name of the working directory without its "ioc"
+ *  prefix (iocBoot/iocXXX convention), else the command name.
+ *
+ *  Reading environ, fd and io of other users' processes needs root or
+ *  CAP_SYS_PTRACE; fds then reads -1 and the I/O counters 0.
+ */
+
+#include <sys/types.h>
+#include <dirent.h>
+#include <fnmatch.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <unistd.h>
+
+#include <devIocStats.h>
+
+typedef struct {
+    int pid;
+    double startTime;
+    int isIoc;
+    int seen;
+} pidCheck;
+
+static pidCheck *checked = NULL;
+static int nChecked = 0;
+
+static int readFile (const char *path, char *buf, int size)
+{
+    FILE *fp;
+    int len;
+
+    fp = fopen(path, "r");
+    if (!fp) return -1;
+    len = fread(buf, 1, size - 1, fp);
+    fclose(fp);
+    if (len < 0) return -1;
+    buf[len] = '\0';
+    return len;
+}
+
+static int statFields (int pid, char *comm, int commSize,
+                       unsigned long *ticks, int *threads, double *start)
+{
+    char path[256];
+    char buf[1024];
+    char *lp, *rp;
+    unsigned long utime, stime;
+    unsigned long long starttime;
+
+    devIocStatsProcPath(path, sizeof(path), "/proc/%d/stat", pid);
+    if (readFile(path, buf, sizeof(buf)) < 0) return -1;
+    if (!(lp = strchr(buf, '(')) || !(rp = strrchr(buf, ')'))) return -1;
+    if (sscanf(rp + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu "
+               "%*d %*d %*d %*d %d %*d %llu",
+               &utime, &stime, threads, &starttime) != 4)
+        return -1;
+    if (comm) {
+        int len = rp - lp - 1;
+        if (len >= commSize) len = commSize - 1;
+        strncpy(comm, lp + 1, len);
+        comm[len] = '\0';
+    }
+    *ticks = utime + stime;
+    *start = (double)starttime;
+    return 0;
+}
+
+static int mapsHaveDb (int pid)
+{
+    char path[256];
+    char line[512];
+    int found = 0;
+    FILE *fp;
+
+    devIocStatsProcPath(path, sizeof(path), "/proc/%d/maps", pid);
+    fp = fopen(path, "r");
+    if (!fp) return 0;
+    while (!found && fgets(line, sizeof(line), fp))
+        if (strstr(line, "/libdbCore.") || strstr(line, "/libdbIoc."))
+            found = 1;
+    fclose(fp);
+    return found;
+}
+
+static int isIocByMaps (int pid, double start)
+{
+    int lo = 0, hi = nChecked - 1, mid;
+    pidCheck *p;
+
+    /* checked[] is sorted by pid */
+    while (lo <= hi) {
+        mid = (lo + hi) / 2;
+        if (checked[mid].pid == pid) {
+            if (checked[mid].startTime != start) {
+                checked[mid].startTime = start;
+                checked[mid].isIoc = mapsHaveDb(pid);
+            }
+            checked[mid].seen = 1;
+            return checked[mid].isIoc;
+        }
+        if (checked[mid].pid < pid) lo = mid + 1; else hi = mid - 1;
+    }
+    p = realloc(checked, (nChecked + 1) * sizeof(pidCheck));
+    if (!p) return mapsHaveDb(pid);
+    checked = p;
+    memmove(&checked[lo + 1], &checked[lo], (nChecked - lo) * sizeof(pidCheck));
+    checked[lo].pid = pid;
+    checked[lo].startTime = start;
+    checked[lo].isIoc = mapsHaveDb(pid);
+    checked[lo].seen = 1;
+    nChecked++;
+    return checked[lo].isIoc;
+}
+
+/* Forget processes that have exited */
+static void pruneChecked (void)
+{
+    int i, j = 0;
+
+    for (i = 0; i < nChecked; i++) {
+        if (!checked[i].seen) continue;
+        checked[i].seen = 0;
+        checked[j++] = checked[i];
+    }
+    nChecked = j;
+}
+
+static void iocName (int pid, const char *comm, char *name)
+{
+    char path[256];
+    char buf[8192];
+    char cwd[1024];
+    char *p, *base;
+    int len;
+
+    devIocStatsProcPath(path, sizeof(path), "/proc/%d/environ", pid);
+    if ((len = readFile(path, buf, sizeof(buf))) > 0) {
+        for (p = buf; p < buf + len; p += strlen(p) + 1) {
+            if (strncmp(p, "IOC=", 4) == 0 && p[4]) {
+                strncpy(name, p + 4, IOC_NAME_SIZE - 1);
+                name[IOC_NAME_SIZE - 1] = '\0';
+                return;
+            }
+        }
+    }
+
+    devIocStatsProcPath(path, sizeof(path), "/proc/%d/cwd", pid);
+    if ((len = readlink(path, cwd, sizeof(cwd) - 1)) > 0) {
+        cwd[len] = '\0';
+        base = strrchr(cwd, '/');
+        base = base ? base + 1 : cwd;
+        if (strncmp(base, "ioc", 3) == 0 && base[3] &&
+            strcmp(base, "iocBoot") != 0) {
+            strncpy(name, base + 3, IOC_NAME_SIZE - 1);
+            name[IOC_NAME_SIZE - 1] = '\0';
+            return;
+        }
+    }
+
+    strncpy(name, comm, IOC_NAME_SIZE - 1);
+    name[IOC_NAME_SIZE - 1] = '\0';
+}
+
+static int matchPattern (int pid, const char *comm, const char *pattern)
+{
+    char path[256];
+    char buf[1024];
+    char *base;
+
+    if (fnmatch(pattern, comm, 0) == 0) return 1;
+    devIocStatsProcPath(path, sizeof(path), "/proc/%d/cmdline", pid);
+    if (readFile(path, buf, sizeof(buf)) <= 0) return 0;
+    base = strrchr(buf, '/');
+    base = base ? base + 1 : buf;
+    return fnmatch(pattern, base, 0) == 0;
+}
+
+int devIocStatsFindIocs (const char *pattern, iocProcId *pval, int max)
+{
+    DIR *pdir;
+    struct dirent *pdit;
+    char comm[64];
+    char procdir[256];
+    unsigned long ticks;
+    double start;
+    int threads;
+    int self = getpid();
+    int pid, n = 0;
+
+    if (pattern && !*pattern) pattern = NULL;
+
+    devIocStatsProcPath(procdir, sizeof(procdir), "/proc");
+    if ((pdir = opendir(procdir)) == NULL) return 0;
+    while (n < max && (pdit = readdir(pdir)) != NULL) {
+        if (!isdigit((unsigned char)pdit->d_name[0])) continue;
+        pid = atoi(pdit->d_name);
+        if (pid == self) continue;
+        if (statFields(pid, comm, sizeof(comm), &ticks, &threads, &start))
+            continue;
+        if (pattern ? !matchPattern(pid, comm, pattern)
+                    : !isIocByMaps(pid, start))
+            continue;
+        pval[n].pid = pid;
+        iocName(pid, comm, pval[n].name);
+        n++;
+    }
+    closedir(pdir);
+    if (!pattern) pruneChecked();
+    return n;
+}
+
+int devIocStatsGetProcStats (int pid, procStats *pval)
+{
+    char path[256];
+    char title[32];
+    unsigned long long value;
+    unsigned long size, resident, ticks;
+    DIR *pdir;
+    struct dirent *pdit;
+    FILE *fp;
+    int i;
+
+    if (statFields(pid, NULL, 0, &ticks, &pval->threads, &pval->startTime))
+        return -1;
+    pval->cpuTime = ticks / (double)TICKS_PER_SEC;
+
+    devIocStatsProcPath(path, sizeof(path), "/proc/%d/statm", pid);
+    fp = fopen(path, "r");
+    if (fp) {
+        if (fscanf(fp, "%lu %lu", &size, &resident) == 2)
+            pval->rss = (double)resident * sysconf(_SC_PAGESIZE);
+        fclose(fp);
+    }
+
+    devIocStatsProcPath(path, sizeof(path), "/proc/%d/fd", pid);
+    pval->fds = -1;
+    if ((pdir = opendir(path)) != NULL) {
+        for (i = 0; (pdit = readdir(pdir)) != NULL; i++) ;
+        closedir(pdir);
+        pval->fds = i - 2; /* Don't count '.' and '..' */
+    }
+
+    devIocStatsProcPath(path, sizeof(path), "/proc/%d/io", pid);
+    fp = fopen(path, "r");
+    if (fp) {
+        while (fscanf(fp, "%31s %llu", title, &value) == 2) {
+            if      (strcmp(title, "rchar:") == 0) pval->readBytes  = value;
+            else if (strcmp(title, "wchar:") == 0) pval->writeBytes = value;
+        }
+        fclose(fp);
+    }
+    return 0;
+}
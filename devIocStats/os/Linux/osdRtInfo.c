@@ -0,0 +1,182 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* osdRtInfo.c - Real-time readiness: Linux implementation =
+ *               use /proc/self/task, /proc/<tid>/timerslack_ns,
+ *               getrlimit() and /sys/kernel/realtime */
+
+/*
+ *  The scheduling policy and priority are fields 41 and 40 of the
+ *  thread's stat file, the affinity is Cpus_allowed_list of its status
+ *  file.  There is no way to ask whether mlockall() was called, so the
+ *  memory counts as locked when VmLck covers VmRSS.
+ */
+
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/utsname.h>
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+
+#include <devIocStats.h>
+
+static const char *policyName (int policy)
+{
+    switch (policy) {
+    case 0: return "OTHER";
+    case 1: return "FIFO";
+    case 2: return "RR";
+    case 3: return "BATCH";
+    case 5: return "IDLE";
+    case 6: return "DEADLINE";
+    default: return "?";
+    }
+}
+
+/* Policy and priority from /proc/self/task/<tid>/stat */
+static int readSched (int tid, rtThread *pt)
+{
+    char path[256];
+    char buf[1024];
+    char *lp, *rp, *tok, *last;
+    int field;
+    FILE *fp;
+
+    devIocStatsProcPath(path, sizeof(path), "/proc/self/task/%d/stat", tid);
+    fp = fopen(path, "r");
+    if (!fp) return -1;
+    lp = fgets(buf, sizeof(buf), fp);
+    fclose(fp);
+    if (!lp || !(lp = strchr(buf, '(')) || !(rp = strrchr(buf, ')')))
+        return -1;
+    *rp = '\0';
+    strncpy(pt->name, lp + 1, sizeof(pt->name) - 1);
+    pt->name[sizeof(pt->name) - 1] = '\0';
+
+    /* Field 3 (state) follows the name */
+    for (field = 3, tok = strtok_r(rp + 2, " ", &last); tok && field < 41;
+         field++, tok = strtok_r(NULL, " ", &last))
+        if (field == 40) pt->priority = atoi(tok);
+    if (!tok) return -1;
+    pt->policy = atoi(tok);
+    strcpy(pt->policyName, policyName(pt->policy));
+    pt->realtime = (pt->policy == 1 || pt->policy == 2 || pt->policy == 6);
+    return 0;
+}
+
+static void readAffinity (int tid, rtThread *pt)
+{
+    char path[256];
+    char line[256];
+    FILE *fp;
+
+    strcpy(pt->affinity, "?");
+    devIocStatsProcPath(path, sizeof(path), "/proc/self/task/%d/status", tid);
+    if (!(fp = fopen(path, "r"))) return;
+    while (fgets(line, sizeof(line), fp))
+        if (sscanf(line, "Cpus_allowed_list: %31s", pt->affinity) == 1) break;
+    fclose(fp);
+}
+
+static void readTimerSlack (int tid, rtThread *pt)
+{
+    char path[256];
+    FILE *fp;
+
+    pt->timerSlack = -1.0;
+    devIocStatsProcPath(path, sizeof(path), "/proc/%d/timerslack_ns", tid);
+    if (!(fp = fopen(path, "r"))) return;
+    if (fscanf(fp, "%lf", &pt->timerSlack) != 1) pt->timerSlack = -1.0;
+    fclose(fp);
+}
+
+int devIocStatsGetRtThreads (rtThread *pval, int max)
+{
+    DIR *pdir;
+    struct dirent *pdit;
+    char taskdir[256];
+    int n = 0;
+
+    devIocStatsProcPath(taskdir, sizeof(taskdir), "/proc/self/task");
+    if ((pdir = opendir(taskdir)) == NULL) return -1;
+    while ((pdit = readdir(pdir)) != NULL && n < max) {
+        if (!isdigit((unsigned char)pdit->d_name[0])) continue;
+        memset(&pval[n], 0, sizeof(rtThread));
+        pval[n].tid = atoi(pdit->d_name);
+        if (readSched(pval[n].tid, &pval[n])) continue;
+        readAffinity(pval[n].tid, &pval[n]);
+        readTimerSlack(pval[n].tid, &pval[n]);
+        n++;
+    }
+    closedir(pdir);
+    return n;
+}
+
+static double rlimitValue (int resource)
+{
+    struct rlimit lim;
+
+    if (getrlimit(resource, &lim) != 0) return 0.0;
+    return lim.rlim_cur == RLIM_INFINITY ? -1.0 : (double)lim.rlim_cur;
+}
+
+static int preemptRt (void)
+{
+    char path[256];
+    struct utsname un;
+    int rt = 0;
+    FILE *fp;
+
+    devIocStatsProcPath(path, sizeof(path), "/sys/kernel/realtime");
+    if ((fp = fopen(path, "r"))) {
+        if (fscanf(fp, "%d", &rt) != 1) rt = 0;
+        fclose(fp);
+    }
+    if (!rt && uname(&un) == 0 && strstr(un.version, "PREEMPT_RT")) rt = 1;
+    return rt;
+}
+
+int devIocStatsInitRtInfo (void) { return 0; }
+
+/* Counts the threads without a buffer, so concurrent calls are safe */
+int devIocStatsGetRtInfo (rtInfo *pval)
+{
+    char statusfile[256];
+    char taskdir[256];
+    char line[256];
+    DIR *pdir;
+    struct dirent *pdit;
+    rtThread thread;
+    double kb;
+    FILE *fp;
+
+    memset(pval, 0, sizeof(rtInfo));
+    fp = fopen(devIocStatsProcPath(statusfile, sizeof(statusfile), "/proc/self/status"), "r");
+    if (!fp) return -1;
+    while (fgets(line, sizeof(line), fp)) {
+        if (sscanf(line, "VmLck: %lf", &kb) == 1) pval->memLocked = kb * 1024;
+        else if (sscanf(line, "VmRSS: %lf", &kb) == 1) pval->memRss = kb * 1024;
+    }
+    fclose(fp);
+
+    devIocStatsProcPath(taskdir, sizeof(taskdir), "/proc/self/task");
+    if ((pdir = opendir(taskdir)) != NULL) {
+        while ((pdit = readdir(pdir)) != NULL) {
+            if (!isdigit((unsigned char)pdit->d_name[0])) continue;
+            if (readSched(atoi(pdit->d_name), &thread)) continue;
+            pval->threads++;
+            if (thread.realtime) pval->rtThreads++;
+        }
+        closedir(pdir);
+    }
+    pval->rtprioLimit = rlimitValue(RLIMIT_RTPRIO);
+    pval->memlockLimit = rlimitValue(RLIMIT_MEMLOCK);
+    pval->preemptRt = preemptRt();
+    return 0;
+}
@@ -0,0 +1,188 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* osdStalls.c - Stalled threads: Linux implementation =
+ *               use /proc/self/task/<tid>/stat, schedstat and wchan */
+
+/*
+ *  A thread is stalled when it has been in uninterruptible sleep (D) or
+ *  runnable (R) without using any CPU time for at least minSeconds.  Any
+ *  CPU time used or a change of state restarts the count, so threads that
+ *  just do a lot of disk I/O don't show up.  CPU time is the run time in
+ *  ns from schedstat (utime + stime in ticks without it), as a busy thread
+ *  can use less than a tick between samples.  The threads are sampled at
+ *  the period of the load collector, which limits the resolution; the
+ *  calling thread is always running and is left out.
+ */
+
+#include <sys/types.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+
+#include <epicsTime.h>
+#include <devIocStats.h>
+
+typedef struct {
+    int tid;
+    int sampled;
+    int seen;                   /* still in /proc at the last sample */
+    char state;                 /* 'D', 'R' or 0 for any other */
+    unsigned long long runtime; /* CPU time at the last sample */
+    epicsTimeStamp since;       /* no progress in this state since */
+} threadEntry;
+
+static threadEntry *threads = NULL;
+static int nThreads = 0;
+static int maxThreads = 0;
+
+static threadEntry *findThread (int tid)
+{
+    int i;
+
+    for (i = 0; i < nThreads; i++)
+        if (threads[i].tid == tid) return &threads[i];
+    if (nThreads == maxThreads) {
+        threadEntry *p = realloc(threads, (maxThreads + 64) * sizeof(threadEntry));
+        if (!p) return NULL;
+        threads = p;
+        maxThreads += 64;
+    }
+    memset(&threads[nThreads], 0, sizeof(threadEntry));
+    threads[nThreads].tid = tid;
+    return &threads[nThreads++];
+}
+
+static void readWchan (int tid, char *buf, size_t size)
+{
+    char path[256];
+    FILE *fp;
+    size_t len = 0;
+
+    devIocStatsProcPath(path, sizeof(path), "/proc/self/task/%d/wchan", tid);
+    if ((fp = fopen(path, "r")) != NULL) {
+        len = fread(buf, 1, size - 1, fp);
+        fclose(fp);
+    }
+    buf[len] = '\0';
+    buf[strcspn(buf, "\n")] = '\0';
+    if (!buf[0] || strcmp(buf, "0") == 0) strcpy(buf, "-");
+}
+
+/* Keep list sorted by descending stall time, STALL_THREADS is small */
+static void insertStall (stallInfo *pval, const stallThread *ps)
+{
+    int i;
+
+    for (i = pval->nList; i > 0; i--) {
+        if (pval->list[i-1].seconds >= ps->seconds) break;
+        if (i < STALL_THREADS) pval->list[i] = pval->list[i-1];
+    }
+    if (i < STALL_THREADS) {
+        pval->list[i] = *ps;
+        if (pval->nList < STALL_THREADS) pval->nList++;
+    }
+}
+
+/* Run time (ns) from schedstat, 0 if not available */
+static unsigned long long schedRuntime (int tid)
+{
+    char path[256];
+    unsigned long long run = 0;
+    FILE *fp;
+
+    devIocStatsProcPath(path, sizeof(path), "/proc/self/task/%d/schedstat", tid);
+    if ((fp = fopen(path, "r")) != NULL) {
+        if (fscanf(fp, "%llu", &run) != 1) run = 0;
+        fclose(fp);
+    }
+    return run;
+}
+
+static void sampleThread (int tid, const epicsTimeStamp *now,
+                          double minSeconds, stallInfo *pval)
+{
+    char path[256];
+    char buf[1024];
+    char *lp, *rp;
+    char state;
+    unsigned long utime, stime;
+    unsigned long long runtime;
+    threadEntry *pe;
+    stallThread st;
+    int isNew;
+    FILE *fp;
+
+    devIocStatsProcPath(path, sizeof(path), "/proc/self/task/%d/stat", tid);
+    fp = fopen(path, "r");
+    if (!fp) return;
+    lp = fgets(buf, sizeof(buf), fp);
+    fclose(fp);
+
+    /* The thread name may contain blanks and parentheses */
+    if (!lp || !(lp = strchr(buf, '(')) || !(rp = strrchr(buf, ')')))
+        return;
+    if (sscanf(rp + 2, "%c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+               &state, &utime, &stime) != 3)
+        return;
+    if (!(runtime = schedRuntime(tid))) runtime = utime + stime;
+    if (state != 'D' && state != 'R') state = 0;
+
+    if (!(pe = findThread(tid))) return;
+    isNew = !pe->sampled;
+    pe->sampled = pe->seen = 1;
+    if (isNew || state != pe->state || runtime != pe->runtime) {
+        pe->state = state;
+        pe->runtime = runtime;
+        pe->since = *now;
+    }
+    if (!state) return;
+    st.seconds = epicsTimeDiffInSeconds(now, &pe->since);
+    if (st.seconds < minSeconds) return;
+
+    pval->n++;
+    *rp = '\0';
+    strncpy(st.name, lp + 1, sizeof(st.name) - 1);
+    st.name[sizeof(st.name) - 1] = '\0';
+    st.state = state;
+    readWchan(tid, st.wchan, sizeof(st.wchan));
+    insertStall(pval, &st);
+}
+
+int devIocStatsInitStalls (void) { return 0; }
+
+int devIocStatsGetStalls (double minSeconds, stallInfo *pval)
+{
+    DIR *pdir;
+    struct dirent *pdit;
+    char taskdir[256];
+    epicsTimeStamp now;
+    int self, tid, i, j;
+
+    /* No thread of its own when replaying a snapshot */
+    self = devIocStatsReplaying() ? 0 : (int)syscall(SYS_gettid);
+    devIocStatsProcPath(taskdir, sizeof(taskdir), "/proc/self/task");
+    if ((pdir = opendir(taskdir)) == NULL) return -1;
+    devIocStatsGetTime(&now);
+    for (i = 0; i < nThreads; i++) threads[i].seen = 0;
+    pval->n = pval->nList = 0;
+    while ((pdit = readdir(pdir)) != NULL) {
+        if (!isdigit((unsigned char)pdit->d_name[0])) continue;
+        tid = atoi(pdit->d_name);
+        if (tid != self) sampleThread(tid, &now, minSeconds, pval);
+    }
+    closedir(pdir);
+
+    /* Drop exited threads */
+    for (i = j = 0; i < nThreads; i++)
+        if (threads[i].seen) threads[j++] = threads[i];
+    nThreads = j;
+    return 0;
+}
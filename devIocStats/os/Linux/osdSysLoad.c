@@ -0,0 +1,86 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* osdSysLoad.c - System load average and run queue: Linux implementation =
+ *                use /proc/loadavg and /proc/schedstat */
+
+/*
+ *  /proc/schedstat is only present with CONFIG_SCHEDSTATS; without it the
+ *  run queue wait reads 0.  Since Linux 5.x, run_delay accounting may
+ *  also need the kernel.sched_schedstats sysctl.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <epicsTime.h>
+#include <devIocStats.h>
+
+static epicsTimeStamp oldTime;
+static double oldWait;
+
+/* Sum of run_delay (sec) over all CPUs, field 8 of the cpu<N> lines */
+static double waitFromSchedstat (void) {
+    char statfile[256];
+    char line[256];
+    unsigned long long v[9];
+    double total = 0.0;
+    FILE *fp;
+
+    fp = fopen(devIocStatsProcPath(statfile, sizeof(statfile), "/proc/schedstat"), "r");
+    if (!fp) return 0.0;
+    while (fgets(line, sizeof(line), fp)) {
+        if (strncmp(line, "cpu", 3) != 0) continue;
+        if (sscanf(line, "%*s %llu %llu %llu %llu %llu %llu %llu %llu %llu",
+                   &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7], &v[8]) >= 8)
+            total += v[7] / 1e9;
+    }
+    fclose(fp);
+    return total;
+}
+
+int devIocStatsInitSysLoad (void) {
+    devIocStatsGetTime(&oldTime);
+    oldWait = waitFromSchedstat();
+    return 0;
+}
+
+int devIocStatsGetSysLoad (sysLoadInfo *pval)
+{
+    char loadfile[256];
+    epicsTimeStamp curTime;
+    double avg[3];
+    double curWait;
+    double elapsed;
+    long ncpus = devIocStatsNoOfCpus();
+    int runnable, total;
+    int i, n;
+    FILE *fp;
+
+    if (ncpus < 1) ncpus = 1;
+
+    fp = fopen(devIocStatsProcPath(loadfile, sizeof(loadfile), "/proc/loadavg"), "r");
+    if (!fp) return -1;
+    n = fscanf(fp, "%lf %lf %lf %d/%d",
+               &avg[0], &avg[1], &avg[2], &runnable, &total);
+    fclose(fp);
+    if (n != 5) return -1;
+    for (i = 0; i < 3; i++)
+        pval->loadAvg[i] = avg[i] / ncpus;
+    pval->runnable = runnable;
+    pval->total = total;
+
+    devIocStatsGetTime(&curTime);
+    curWait = waitFromSchedstat();
+    elapsed = epicsTimeDiffInSeconds(&curTime, &oldTime);
+
+    pval->runqWait = (elapsed > 0 && curWait > oldWait) ?
+                     1000.0 * (curWait - oldWait) / (elapsed * ncpus) : 0.0;
+
+    oldTime = curTime;
+    oldWait = curWait;
+    return 0;
+}
@@ -0,0 +1,196 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* osdTopProcs.c - Top foreign processes: Linux implementation = use /proc/<pid>/stat */
+
+/*
+ *  Every call lists the pids in /proc (cheap, no files opened), but reads
+ *  the stat files of at most TOP_PROCS_PER_SCAN processes, continuing
+ *  where the previous call stopped.  The CPU load of a process is computed
+ *  over the interval between its own last two samples, so on a host with
+ *  thousands of processes the values are just averaged over a longer
+ *  window instead of making each call expensive.
+ */
+
+#include <sys/types.h>
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <unistd.h>
+
+#include <epicsTime.h>
+#include <devIocStats.h>
+
+#define TOP_PROCS_PER_SCAN 500
+
+typedef struct {
+    int pid;
+    int sampled;                /* number of samples taken (max 2) */
+    double startTime;           /* start time (ticks), tells reused pids apart */
+    double usage;               /* sec of CPU time at the last sample */
+    epicsTimeStamp time;        /* time of the last sample */
+    procInfo info;
+} procEntry;
+
+static procEntry *entries = NULL;
+static int nEntries = 0;
+static int *pids = NULL;
+static int maxPids = 0;
+static int cursor = 0;          /* next pid to sample */
+static int selfPid;
+static unsigned long pagesize;
+
+static int pidCompare (const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+/* Sorted list of the pids currently in /proc */
+static int listPids (void)
+{
+    DIR *pdir;
+    struct dirent *pdit;
+    char procdir[256];
+    int n = 0;
+
+    devIocStatsProcPath(procdir, sizeof(procdir), "/proc");
+    if ((pdir = opendir(procdir)) == NULL) return -1;
+    while ((pdit = readdir(pdir)) != NULL) {
+        if (!isdigit((unsigned char)pdit->d_name[0])) continue;
+        if (n == maxPids) {
+            int *p = realloc(pids, (maxPids + 1024) * sizeof(int));
+            if (!p) break;
+            pids = p;
+            maxPids += 1024;
+        }
+        pids[n++] = atoi(pdit->d_name);
+    }
+    closedir(pdir);
+    qsort(pids, n, sizeof(int), pidCompare);
+    return n;
+}
+
+/* Merge the new pid list into the entry table, dropping exited processes */
+static int mergePids (int nPids)
+{
+    procEntry *merged;
+    int i, j = 0;
+
+    merged = calloc(nPids ? nPids : 1, sizeof(procEntry));
+    if (!merged) return -1;
+    for (i = 0; i < nPids; i++) {
+        while (j < nEntries && entries[j].pid < pids[i]) j++;
+        if (j < nEntries && entries[j].pid == pids[i])
+            merged[i] = entries[j];
+        else
+            merged[i].pid = pids[i];
+    }
+    free(entries);
+    entries = merged;
+    nEntries = nPids;
+    return 0;
+}
+
+static void sampleEntry (procEntry *pe)
+{
+    char path[256];
+    char buf[1024];
+    char *lp, *rp;
+    unsigned long utime, stime;
+    unsigned long long starttime;
+    long rss;
+    double usage;
+    epicsTimeStamp now;
+    FILE *fp;
+
+    devIocStatsProcPath(path, sizeof(path), "/proc/%d/stat", pe->pid);
+    fp = fopen(path, "r");
+    if (!fp) return;
+    lp = fgets(buf, sizeof(buf), fp);
+    fclose(fp);
+    devIocStatsGetTime(&now);
+
+    /* The command name may contain blanks and parentheses */
+    if (!lp || !(lp = strchr(buf, '(')) || !(rp = strrchr(buf, ')')))
+        return;
+    if (sscanf(rp + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu "
+               "%*d %*d %*d %*d %*d %*d %llu %*u %ld",
+               &utime, &stime, &starttime, &rss) != 4)
+        return;
+
+    /* A reused pid is a new process */
+    if (pe->sampled && pe->startTime != (double)starttime) {
+        pe->sampled = 0;
+        pe->info.cpuLoad = 0.0;
+    }
+    pe->startTime = (double)starttime;
+
+    *rp = '\0';
+    strncpy(pe->info.comm, lp + 1, sizeof(pe->info.comm) - 1);
+    pe->info.comm[sizeof(pe->info.comm) - 1] = '\0';
+    pe->info.pid = pe->pid;
+    pe->info.rss = (double)rss * pagesize;
+
+    usage = (utime + stime) / (double)TICKS_PER_SEC;
+    if (pe->sampled) {
+        double elapsed = epicsTimeDiffInSeconds(&now, &pe->time);
+        if (elapsed > 0)
+            pe->info.cpuLoad = 100.0 * (usage - pe->usage) / elapsed;
+    }
+    if (pe->sampled < 2) pe->sampled++;
+    pe->usage = usage;
+    pe->time = now;
+}
+
+/* Keep list sorted by descending key, K is small so insertion is fine */
+static void insertTop (procInfo *list, int *n, const procInfo *pi, int byCpu)
+{
+    double key = byCpu ? pi->cpuLoad : pi->rss;
+    int i;
+
+    for (i = *n; i > 0; i--) {
+        double other = byCpu ? list[i-1].cpuLoad : list[i-1].rss;
+        if (other >= key) break;
+        if (i < TOP_PROCS) list[i] = list[i-1];
+    }
+    if (i < TOP_PROCS) {
+        list[i] = *pi;
+        if (*n < TOP_PROCS) (*n)++;
+    }
+}
+
+int devIocStatsInitTopProcs (void) {
+    selfPid = getpid();
+    pagesize = sysconf(_SC_PAGESIZE);
+    return 0;
+}
+
+int devIocStatsGetTopProcs (topProcInfo *pval)
+{
+    int nPids, start, i, n;
+
+    if ((nPids = listPids()) < 0 || mergePids(nPids)) return -1;
+    if (nEntries == 0) return 0;
+
+    /* Continue sampling at the first pid not below the cursor */
+    for (start = 0; start < nEntries && entries[start].pid < cursor; start++) ;
+    if (start == nEntries) start = 0;
+    n = nEntries < TOP_PROCS_PER_SCAN ? nEntries : TOP_PROCS_PER_SCAN;
+    for (i = 0; i < n; i++)
+        sampleEntry(&entries[(start + i) % nEntries]);
+    cursor = entries[(start + n) % nEntries].pid;
+
+    pval->nCpu = pval->nMem = 0;
+    for (i = 0; i < nEntries; i++) {
+        procEntry *pe = &entries[i];
+        if (pe->pid == selfPid || !pe->sampled) continue;
+        if (pe->sampled > 1) insertTop(pval->byCpu, &pval->nCpu, &pe->info, 1);
+        insertTop(pval->byMem, &pval->nMem, &pe->info, 0);
+    }
+    return 0;
+}
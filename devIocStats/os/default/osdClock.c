@@ -0,0 +1,30 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* osdClock.c - Clocks for timing the collectors: default implementation =
+ *              use the EPICS time, no thread CPU time */
+
+#include <epicsTime.h>
+#include <epicsThread.h>
+#include <devIocStats.h>
+
+double devIocStatsClock (void)
+{
+    epicsTimeStamp now;
+
+    epicsTimeGetCurrent(&now);
+    return now.secPastEpoch + now.nsec / 1e9;
+}
+
+double devIocStatsThreadCpuTime (void) { return 0.0; }
+double devIocStatsProcessCpuTime (void) { return 0.0; }
+
+void devIocStatsSleepUntil (double deadline)
+{
+    double delay = deadline - devIocStatsClock();
+
+    if (delay > 0) epicsThreadSleep(delay);
+}
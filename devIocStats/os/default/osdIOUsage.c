@@ -0,0 +1,12 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* osdIOUsage.c - Process I/O and delay accounting: default implementation = do nothing */
+
+#include <devIocStats.h>
+
+int devIocStatsInitIOUsage (void) { return 0; }
+int devIocStatsGetIOUsage (ioInfo *pval) { return -1; }
@@ -0,0 +1,13 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* osdLimits.c - Thread count and resource limits: default implementation = do nothing */
+
+#include <devIocStats.h>
+
+int devIocStatsInitLimits (void) { return 0; }
+int devIocStatsGetLimits (limitInfo *pval) { return -1; }
+int devIocStatsGetMemLimit (double *pval) { return -1; }
@@ -0,0 +1,14 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* osdPlacement.c - CPU affinity and scheduling policy of a thread:
+ *                  default implementation = not supported */
+
+#include <devIocStats.h>
+
+int devIocStatsCheckPlacement (const char *cpus, const char *policy) { return -1; }
+int devIocStatsPlaceThread (int tid, const char *cpus, const char *policy,
+                            int priority) { return -1; }
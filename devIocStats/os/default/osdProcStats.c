@@ -0,0 +1,12 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* osdProcStats.c - Processes of other IOCs: default implementation = do nothing */
+
+#include <devIocStats.h>
+
+int devIocStatsFindIocs (const char *pattern, iocProcId *pval, int max) { return 0; }
+int devIocStatsGetProcStats (int pid, procStats *pval) { return -1; }
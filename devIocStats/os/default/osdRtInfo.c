@@ -0,0 +1,13 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* osdRtInfo.c - Real-time readiness: default implementation = do nothing */
+
+#include <devIocStats.h>
+
+int devIocStatsInitRtInfo (void) { return 0; }
+int devIocStatsGetRtInfo (rtInfo *pval) { return -1; }
+int devIocStatsGetRtThreads (rtThread *pval, int max) { return -1; }
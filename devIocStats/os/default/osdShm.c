@@ -0,0 +1,12 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* osdShm.c - Shared memory statistics segment: default implementation = do nothing */
+
+#include <devIocStats.h>
+
+int devIocStatsInitShm (void) { return -1; }
+int devIocStatsPublishShm (const iocStatsShm *pval) { return -1; }
@@ -0,0 +1,12 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* osdStalls.c - Stalled threads: default implementation = do nothing */
+
+#include <devIocStats.h>
+
+int devIocStatsInitStalls (void) { return 0; }
+int devIocStatsGetStalls (double minSeconds, stallInfo *pval) { return -1; }
@@ -0,0 +1,12 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* osdSysLoad.c - System load average and run queue: default implementation = do nothing */
+
+#include <devIocStats.h>
+
+int devIocStatsInitSysLoad (void) { return 0; }
+int devIocStatsGetSysLoad (sysLoadInfo *pval) { return -1; }
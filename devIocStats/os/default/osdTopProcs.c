@@ -0,0 +1,12 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* osdTopProcs.c - Top foreign processes: default implementation = do nothing */
+
+#include <devIocStats.h>
+
+int devIocStatsInitTopProcs (void) { return 0; }
+int devIocStatsGetTopProcs (topProcInfo *pval) { return -1; }
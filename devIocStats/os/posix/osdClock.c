@@ -0,0 +1,73 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* osdClock.c - Clocks for timing the collectors: posix implementation =
+ *              use the monotonic, thread and process CPU-time clocks */
+
+#include <time.h>
+#include <errno.h>
+
+#include <epicsTime.h>
+#include <epicsThread.h>
+#include <devIocStats.h>
+
+double devIocStatsClock (void)
+{
+#if defined(_POSIX_MONOTONIC_CLOCK) && _POSIX_MONOTONIC_CLOCK >= 0
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+    {
+        epicsTimeStamp now;
+        epicsTimeGetCurrent(&now);
+        return now.secPastEpoch + now.nsec / 1e9;
+    }
+}
+
+double devIocStatsThreadCpuTime (void)
+{
+#if defined(_POSIX_THREAD_CPUTIME) && _POSIX_THREAD_CPUTIME >= 0
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+    return 0.0;
+}
+
+double devIocStatsProcessCpuTime (void)
+{
+#if defined(_POSIX_CPUTIME) && _POSIX_CPUTIME >= 0
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) == 0)
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+    return 0.0;
+}
+
+/* Sleep until an absolute devIocStatsClock() time */
+void devIocStatsSleepUntil (double deadline)
+{
+#if defined(_POSIX_MONOTONIC_CLOCK) && _POSIX_MONOTONIC_CLOCK >= 0 && \
+    defined(_POSIX_CLOCK_SELECTION) && _POSIX_CLOCK_SELECTION >= 0
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)deadline;
+    ts.tv_nsec = (long)((deadline - ts.tv_sec) * 1e9);
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) ;
+#else
+    double delay = deadline - devIocStatsClock();
+
+    if (delay > 0) epicsThreadSleep(delay);
+#endif
+}
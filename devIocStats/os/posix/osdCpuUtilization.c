@@ -10,7 +10,8 @@
 * in file LICENSE that is included with this distribution.
 \*************************************************************************/
 
-/* osdCpuUtilization.c - CPU utilization info: posix implementation = use getrusage() */
+/* osdCpuUtilization.c - CPU utilization info: posix implementation = use the
+ *                        process CPU-time clock or getrusage() */
 
 /*
  *  Author: Ralph Lange (HZB/BESSY)
@@ -21,6 +22,7 @@
 
 #include <sys/time.h>
 #include <sys/resource.h>
+#include <time.h>
 
 #include <epicsTime.h>
 #include <devIocStats.h>
@@ -29,14 +31,30 @@ static epicsTimeStamp oldTime;
 static double oldUsage;
 static double scale;
 
-int devIocStatsInitCpuUtilization (loadInfo *pval) {
+static double usageFromRusage (void) {
     struct rusage stats;
 
-    epicsTimeGetCurrent(&oldTime);
     getrusage(RUSAGE_SELF, &stats);
-    oldUsage = stats.ru_utime.tv_sec + stats.ru_utime.tv_usec / 1e6 +
-               stats.ru_stime.tv_sec + stats.ru_stime.tv_usec / 1e6;
-    scale = 100.0f / ((double)TICKS_PER_SEC * NO_OF_CPUS);
+    return stats.ru_utime.tv_sec + stats.ru_utime.tv_usec / 1e6 +
+           stats.ru_stime.tv_sec + stats.ru_stime.tv_usec / 1e6;
+}
+
+/* ns resolution where available; getrusage() is often tick based */
+static double usageFromClock (void) {
+#if defined(_POSIX_CPUTIME) && _POSIX_CPUTIME >= 0
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) == 0)
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+    return usageFromRusage();
+}
+
+int devIocStatsInitCpuUtilization (loadInfo *pval) {
+    devIocStatsGetTime(&oldTime);
+    oldUsage = usageFromClock();
+    /* Usage is in seconds already, no tick conversion */
+    scale = 100.0f / NO_OF_CPUS;
     pval->noOfCpus = NO_OF_CPUS;
     return 0;
 }
@@ -45,14 +63,11 @@ int devIocStatsGetCpuUtilization (loadInfo *pval)
 {
     epicsTimeStamp curTime;
     double curUsage;
-    struct rusage stats;
     double elapsed;
     double cpuFract;
 
-    epicsTimeGetCurrent(&curTime);
-    getrusage(RUSAGE_SELF, &stats);
-    curUsage = stats.ru_utime.tv_sec + stats.ru_utime.tv_usec / 1e6 +
-               stats.ru_stime.tv_sec + stats.ru_stime.tv_usec / 1e6;
+    devIocStatsGetTime(&curTime);
+    curUsage = usageFromClock();
     elapsed = epicsTimeDiffInSeconds(&curTime, &oldTime);
 
     cpuFract = (elapsed > 0) ? (curUsage - oldUsage) * scale / elapsed : 0.0;
@@ -0,0 +1,94 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* osdShm.c - Shared memory statistics segment: posix implementation = use shm_open() */
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <stdio.h>
+
+#include <epicsExit.h>
+#include <devIocStats.h>
+
+#if defined(__GNUC__)
+#define MEMORY_BARRIER() __sync_synchronize()
+#else
+#define MEMORY_BARRIER()
+#endif
+
+static char shmName[32];
+static iocStatsShm *pshm = NULL;
+
+static void removeShm (void *arg)
+{
+    shm_unlink(shmName);
+}
+
+int devIocStatsInitShm (void)
+{
+    int fd;
+    void *addr;
+
+    if (pshm) return 0;
+    sprintf(shmName, IOCSTATS_SHM_PREFIX "%d", (int)getpid());
+
+    /* A segment left behind by an earlier process with the same pid */
+    shm_unlink(shmName);
+    fd = shm_open(shmName, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) return -1;
+    if (ftruncate(fd, sizeof(iocStatsShm)) < 0) {
+        close(fd);
+        shm_unlink(shmName);
+        return -1;
+    }
+    addr = mmap(NULL, sizeof(iocStatsShm), PROT_READ | PROT_WRITE,
+                MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        shm_unlink(shmName);
+        return -1;
+    }
+    pshm = (iocStatsShm *)addr;
+    /* ftruncate() zero-fills; magic is set last so readers skip the
+       segment until it is complete */
+    pshm->version = IOCSTATS_SHM_VERSION;
+    pshm->size    = sizeof(iocStatsShm);
+    pshm->pid     = getpid();
+    MEMORY_BARRIER();
+    pshm->magic   = IOCSTATS_SHM_MAGIC;
+    epicsAtExit(removeShm, NULL);
+    return 0;
+}
+
+int devIocStatsPublishShm (const iocStatsShm *pval)
+{
+    unsigned int seq;
+
+    if (!pshm) return -1;
+    seq = pshm->seq;
+    pshm->seq = seq + 1;
+    MEMORY_BARRIER();
+    pshm->noOfCpus      = pval->noOfCpus;
+    memcpy(pshm->name, pval->name, sizeof(pshm->name));
+    pshm->updateTime    = pval->updateTime;
+    pshm->iocCpuLoad    = pval->iocCpuLoad;
+    pshm->sysCpuLoad    = pval->sysCpuLoad;
+    pshm->memAlloc      = pval->memAlloc;
+    pshm->memFree       = pval->memFree;
+    pshm->memTotal      = pval->memTotal;
+    pshm->fdUsed        = pval->fdUsed;
+    pshm->fdMax         = pval->fdMax;
+    pshm->caClients     = pval->caClients;
+    pshm->caConnections = pval->caConnections;
+    pshm->scanLateness  = pval->scanLateness;
+    pshm->ioReadRate    = pval->ioReadRate;
+    pshm->ioWriteRate   = pval->ioWriteRate;
+    MEMORY_BARRIER();
+    pshm->seq = seq + 2;
+    return 0;
+}
@@ -0,0 +1,29 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* osdSysLoad.c - System load average: posix implementation = use getloadavg() */
+
+#include <stdlib.h>
+#ifdef __sun
+#include <sys/loadavg.h>
+#endif
+
+#include <devIocStats.h>
+
+int devIocStatsInitSysLoad (void) { return 0; }
+
+int devIocStatsGetSysLoad (sysLoadInfo *pval)
+{
+    double avg[3];
+    long ncpus = NO_OF_CPUS;
+    int i;
+
+    if (getloadavg(avg, 3) != 3) return -1;
+    if (ncpus < 1) ncpus = 1;
+    for (i = 0; i < 3; i++)
+        pval->loadAvg[i] = avg[i] / ncpus;
+    return 0;
+}
@@ -0,0 +1,371 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* devHostStats.c - Device Support Routines for the statistics of all IOCs
+ *                  running on a host, collected by one host statistics IOC */
+
+/*
+	--------------------------------------------------------------------
+	The host statistics IOC loads the usual iocAdminSoft records with the
+	host name as prefix for the host-wide values (CPU, memory, load) and
+	one set of hostStatsIoc records per IOC found on the host.  The IOCs
+	themselves can then stop their host-wide collectors with
+		var devIocStatsHostStats 0
+
+	INP field of the ai records (DTYP="Host IOC stats"):
+		@<ioc> <parm>
+
+	where <ioc> is the IOC name (see devIocStatsFindIocs) and <parm> is:
+		pid		 - process ID, 0 while the IOC is not running
+		running		 - 1 while the IOC is running, else 0
+		cpu_load	 - estimated percent CPU utilization by the IOC
+		rss		 - resident memory in bytes
+		threads		 - number of threads
+		fd		 - number of file descriptors in use
+		io_read_rate	 - bytes/sec read (all read calls)
+		io_write_rate	 - bytes/sec written (all write calls)
+
+	All parms except running are INVALID while the IOC is not running.
+
+	iocsh commands (before iocInit):
+		hostStatsConfig <period> <pattern>
+		    scan period in seconds (default 10) and glob pattern for
+		    the process or executable name of the IOCs (default: all
+		    processes that use the EPICS database library)
+		hostStatsLoadRecords <db> <macros>
+		    dbLoadRecords(<db>, "IOC=<ioc>,<macros>") for each IOC
+		    currently running
+	--------------------------------------------------------------------
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <epicsThread.h>
+#include <epicsMutex.h>
+#include <epicsTime.h>
+#include <dbAccess.h>
+#include <dbScan.h>
+#include <devSup.h>
+#include <alarm.h>
+#include <menuConvert.h>
+#include <aiRecord.h>
+#include <recGbl.h>
+#include <iocsh.h>
+#include <epicsExport.h>
+
+#include "devIocStats.h"
+
+#define HOST_STATS_MAX_IOCS 256
+
+struct aStats
+{
+	long		number;
+	DEVSUPFUN	report;
+	DEVSUPFUN	init;
+	DEVSUPFUN	init_record;
+	DEVSUPFUN	get_ioint_info;
+	DEVSUPFUN	read_write;
+	DEVSUPFUN	special_linconv;
+};
+typedef struct aStats aStats;
+
+typedef struct {
+	double pid;
+	double cpuLoad;
+	double rss;
+	double threads;
+	double fds;
+	double readRate;
+	double writeRate;
+} iocValues;
+
+typedef struct {
+	char name[IOC_NAME_SIZE];
+	int pid;			/* 0 while not running */
+	procStats old;			/* last sample, collector only */
+	epicsTimeStamp oldTime;
+	iocValues val;			/* protected by hostMutex */
+} hostIoc;
+
+struct pvtArea
+{
+	int ioc;
+	int parm;
+};
+typedef struct pvtArea pvtArea;
+
+enum { PARM_PID, PARM_RUNNING, PARM_CPU_LOAD, PARM_RSS, PARM_THREADS,
+       PARM_FD, PARM_READ_RATE, PARM_WRITE_RATE };
+
+static char *parmNames[] = {
+	"pid", "running", "cpu_load", "rss", "threads", "fd",
+	"io_read_rate", "io_write_rate", NULL
+};
+
+static long ai_report(int level);
+static long ai_init(int pass);
+static long ai_init_record(aiRecord*);
+static long ai_ioint_info(int cmd,aiRecord* pr,IOSCANPVT* iopvt);
+static long ai_read(aiRecord*);
+
+aStats devAiHostStats={ 6,ai_report,ai_init,ai_init_record,ai_ioint_info,ai_read,NULL };
+epicsExportAddress(dset,devAiHostStats);
+
+static hostIoc iocs[HOST_STATS_MAX_IOCS];
+static int nIocs = 0;
+static epicsMutexId hostMutex;
+static IOSCANPVT hostScan;
+static double hostStatsPeriod = 10.0;
+static char *hostStatsPattern = NULL;
+
+/* -------------------------------------------------------------------- */
+
+static int findIoc (const char *name, int create)
+{
+	int i;
+
+	for (i = 0; i < nIocs; i++)
+		if (strcmp(iocs[i].name, name) == 0) return i;
+	if (!create || nIocs >= HOST_STATS_MAX_IOCS) return -1;
+	memset(&iocs[nIocs], 0, sizeof(hostIoc));
+	strncpy(iocs[nIocs].name, name, IOC_NAME_SIZE - 1);
+	return nIocs++;
+}
+
+static void hostStatsScan (void)
+{
+	static iocProcId ids[HOST_STATS_MAX_IOCS];
+	double cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	epicsTimeStamp now;
+	procStats cur;
+	iocValues val;
+	double elapsed;
+	int n, i, j;
+
+	if (cpus < 1) cpus = 1;
+	n = devIocStatsFindIocs(hostStatsPattern, ids, HOST_STATS_MAX_IOCS);
+	epicsTimeGetCurrent(&now);
+
+	for (i = 0; i < nIocs; i++) {
+		hostIoc *pioc = &iocs[i];
+
+		memset(&val, 0, sizeof(val));
+		memset(&cur, 0, sizeof(cur));
+		for (j = 0; j < n; j++)
+			if (strcmp(ids[j].name, pioc->name) == 0) break;
+
+		if (j < n && devIocStatsGetProcStats(ids[j].pid, &cur) == 0) {
+			val.pid     = ids[j].pid;
+			val.rss     = cur.rss;
+			val.threads = cur.threads;
+			val.fds     = cur.fds;
+			elapsed = epicsTimeDiffInSeconds(&now, &pioc->oldTime);
+			/* Rates need two samples of the same process */
+			if (pioc->pid == ids[j].pid &&
+			    pioc->old.startTime == cur.startTime && elapsed > 0) {
+				val.cpuLoad = 100.0 * (cur.cpuTime - pioc->old.cpuTime)
+						/ elapsed / cpus;
+				if (cur.readBytes >= pioc->old.readBytes)
+					val.readRate = (cur.readBytes - pioc->old.readBytes) / elapsed;
+				if (cur.writeBytes >= pioc->old.writeBytes)
+					val.writeRate = (cur.writeBytes - pioc->old.writeBytes) / elapsed;
+			}
+			pioc->pid = ids[j].pid;
+		} else {
+			pioc->pid = 0;
+		}
+		pioc->old = cur;
+		pioc->oldTime = now;
+
+		epicsMutexLock(hostMutex);
+		pioc->val = val;
+		epicsMutexUnlock(hostMutex);
+	}
+}
+
+static void hostStatsTask (void *parm)
+{
+	for (;;) {
+		hostStatsScan();
+		scanIoRequest(hostScan);
+		epicsThreadSleep(hostStatsPeriod);
+	}
+}
+
+/* -------------------------------------------------------------------- */
+
+static long ai_report(int level)
+{
+	int i;
+
+	printf("Host IOC stats: %d IOCs, period %g s, pattern \"%s\"\n",
+	       nIocs, hostStatsPeriod, hostStatsPattern ? hostStatsPattern : "");
+	if (level < 1) return 0;
+	for (i = 0; i < nIocs; i++) {
+		iocValues val;
+		epicsMutexLock(hostMutex);
+		val = iocs[i].val;
+		epicsMutexUnlock(hostMutex);
+		printf("  %-20s pid %6.0f cpu %5.1f%% rss %10.0f threads %3.0f fds %4.0f\n",
+		       iocs[i].name, val.pid, val.cpuLoad, val.rss, val.threads, val.fds);
+	}
+	return 0;
+}
+
+static long ai_init(int pass)
+{
+	if (pass == 0) {
+		hostMutex = epicsMutexMustCreate();
+		scanIoInit(&hostScan);
+		return 0;
+	}
+	if (nIocs == 0) return 0;
+	hostStatsScan();
+	epicsThreadCreate("hostStats", epicsThreadPriorityLow,
+	                  epicsThreadGetStackSize(epicsThreadStackMedium),
+	                  hostStatsTask, NULL);
+	return 0;
+}
+
+static long ai_init_record(aiRecord* pr)
+{
+	char name[IOC_NAME_SIZE];
+	char parm[32];
+	int i, ioc;
+	pvtArea *pvt = NULL;
+
+	if(pr->inp.type!=INST_IO)
+	{
+		recGblRecordError(S_db_badField,(void*)pr,
+			"devAiHostStats (init_record) Illegal INP field");
+		return S_db_badField;
+	}
+	if (sscanf(pr->inp.value.instio.string, "%39s %31s", name, parm) == 2 &&
+	    (ioc = findIoc(name, 1)) >= 0)
+	{
+		for(i=0;parmNames[i] && pvt==NULL;i++)
+		{
+			if(strcmp(parm,parmNames[i])==0)
+			{
+				pvt=(pvtArea*)malloc(sizeof(pvtArea));
+				pvt->ioc=ioc;
+				pvt->parm=i;
+			}
+		}
+	}
+	if(pvt==NULL)
+	{
+		recGblRecordError(S_db_badField,(void*)pr,
+			"devAiHostStats (init_record) Illegal INP parm field");
+		return S_db_badField;
+	}
+
+	/* Make sure record processing routine does not perform any conversion*/
+	pr->linr=menuConvertNO_CONVERSION;
+	pr->dpvt=pvt;
+	return 0;
+}
+
+static long ai_ioint_info(int cmd,aiRecord* pr,IOSCANPVT* iopvt)
+{
+	*iopvt = hostScan;
+	return 0;
+}
+
+static long ai_read(aiRecord* pr)
+{
+	iocValues val;
+	pvtArea* pvt=(pvtArea*)pr->dpvt;
+
+	if (!pvt) return S_dev_badInpType;
+
+	epicsMutexLock(hostMutex);
+	val = iocs[pvt->ioc].val;
+	epicsMutexUnlock(hostMutex);
+
+	if (pvt->parm == PARM_RUNNING) {
+		pr->val = (val.pid != 0);
+		pr->udf = 0;
+		return 2;
+	}
+	if (val.pid == 0) {
+		recGblSetSevr(pr, READ_ALARM, INVALID_ALARM);
+		return 2;
+	}
+	switch (pvt->parm) {
+	case PARM_PID:		pr->val = val.pid;	break;
+	case PARM_CPU_LOAD:	pr->val = val.cpuLoad;	break;
+	case PARM_RSS:		pr->val = val.rss;	break;
+	case PARM_THREADS:	pr->val = val.threads;	break;
+	case PARM_FD:		pr->val = val.fds;	break;
+	case PARM_READ_RATE:	pr->val = val.readRate;	break;
+	case PARM_WRITE_RATE:	pr->val = val.writeRate; break;
+	}
+	pr->udf = 0;
+	return 2; /* don't convert */
+}
+
+/* -------------------------------------------------------------------- */
+
+static const iocshArg hostStatsConfigArg0 = { "period", iocshArgDouble };
+static const iocshArg hostStatsConfigArg1 = { "pattern", iocshArgString };
+static const iocshArg * const hostStatsConfigArgs[] = {
+	&hostStatsConfigArg0, &hostStatsConfigArg1
+};
+static const iocshFuncDef hostStatsConfigDef = {
+	"hostStatsConfig", 2, hostStatsConfigArgs
+};
+static void hostStatsConfigCall(const iocshArgBuf *args)
+{
+	if (args[0].dval > 0) hostStatsPeriod = args[0].dval;
+	free(hostStatsPattern);
+	hostStatsPattern = (args[1].sval && *args[1].sval) ?
+		strdup(args[1].sval) : NULL;
+}
+
+static const iocshArg hostStatsLoadRecordsArg0 = { "db", iocshArgString };
+static const iocshArg hostStatsLoadRecordsArg1 = { "macros", iocshArgString };
+static const iocshArg * const hostStatsLoadRecordsArgs[] = {
+	&hostStatsLoadRecordsArg0, &hostStatsLoadRecordsArg1
+};
+static const iocshFuncDef hostStatsLoadRecordsDef = {
+	"hostStatsLoadRecords", 2, hostStatsLoadRecordsArgs
+};
+static void hostStatsLoadRecordsCall(const iocshArgBuf *args)
+{
+	static iocProcId ids[HOST_STATS_MAX_IOCS];
+	const char *macros = args[1].sval;
+	char *subst;
+	int n, i, j;
+
+	if (!args[0].sval) {
+		printf("Usage: hostStatsLoadRecords <db> <macros>\n");
+		return;
+	}
+	n = devIocStatsFindIocs(hostStatsPattern, ids, HOST_STATS_MAX_IOCS);
+	for (i = 0; i < n; i++) {
+		/* The same IOC name may show up more than once */
+		for (j = 0; j < i; j++)
+			if (strcmp(ids[j].name, ids[i].name) == 0) break;
+		if (j < i) continue;
+		subst = malloc(strlen(ids[i].name) + (macros ? strlen(macros) : 0) + 6);
+		if (!subst) return;
+		sprintf(subst, "IOC=%s%s%s", ids[i].name,
+		        (macros && *macros) ? "," : "", macros ? macros : "");
+		dbLoadRecords(args[0].sval, subst);
+		free(subst);
+	}
+}
+
+static void devHostStatsRegister(void)
+{
+	iocshRegister(&hostStatsConfigDef, hostStatsConfigCall);
+	iocshRegister(&hostStatsLoadRecordsDef, hostStatsLoadRecordsCall);
+}
+epicsExportRegistrar(devHostStatsRegister);
@@ -0,0 +1,32 @@
+#!../../bin/linux-x86_64/iocStatsBench
+< envPaths
+
+cd ${TOP}
+
+## Register all support components
+dbLoadDatabase("dbd/iocStatsBench.dbd",0,0)
+iocStatsBench_registerRecordDeviceDriver(pdbbase)
+
+## Ten copies of the soft IOC records plus the timing records
+dbLoadRecords("db/iocAdminSoft.db","IOC=BENCH0")
+dbLoadRecords("db/iocAdminSoft.db","IOC=BENCH1")
+dbLoadRecords("db/iocAdminSoft.db","IOC=BENCH2")
+dbLoadRecords("db/iocAdminSoft.db","IOC=BENCH3")
+dbLoadRecords("db/iocAdminSoft.db","IOC=BENCH4")
+dbLoadRecords("db/iocAdminSoft.db","IOC=BENCH5")
+dbLoadRecords("db/iocAdminSoft.db","IOC=BENCH6")
+dbLoadRecords("db/iocAdminSoft.db","IOC=BENCH7")
+dbLoadRecords("db/iocAdminSoft.db","IOC=BENCH8")
+dbLoadRecords("db/iocAdminSoft.db","IOC=BENCH9")
+dbLoadRecords("db/iocAdminTiming.db","IOC=BENCH0")
+
+iocInit()
+
+## Scaling with the number of fds and threads; rows go to bench.csv
+## (use a name ending in .json for JSON lines)
+iocStatsBench("bench.csv", 0, 0, 0.2)
+iocStatsBench("bench.csv", 100, 10, 0.2)
+iocStatsBench("bench.csv", 500, 100, 0.2)
+iocStatsBench("bench.csv", 900, 500, 0.2)
+iocStatsShow(1)
+exit
@@ -0,0 +1,21 @@
+#!../../bin/linux-x86_64/iocStatsBench
+< envPaths
+
+cd ${TOP}
+
+## Register all support components
+dbLoadDatabase("dbd/iocStatsBench.dbd",0,0)
+iocStatsBench_registerRecordDeviceDriver(pdbbase)
+
+## 20000 records, 5000 of them I/O Intr IOC stats records SCALE:S<n>
+## (change the numbers for 10k - 100k records)
+iocStatsScaleRecords("/tmp/iocStatsScale.db", "SCALE", 20000, 5000)
+dbLoadRecords("db/iocAdminTiming.db","IOC=SCALE")
+
+iocInit()
+
+## Init time, then the per-cycle collector cost and read fan-out.
+## Start CA clients from other shells, e.g.
+##	bin/linux-x86_64/iocStatsCaLoad SCALE 5000 5000 60
+## and repeat iocStatsScaleShow to see the cost under monitor load.
+iocStatsScaleShow
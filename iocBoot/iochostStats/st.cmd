@@ -0,0 +1,31 @@
+#!../../bin/linux-x86_64/hostStats
+< envPaths
+
+cd ${TOP}
+
+epicsEnvSet("HOST","$(HOST=HOSTSTATS)")
+epicsEnvSet("ENGINEER","$(ENGINEER=engineer)")
+epicsEnvSet("LOCATION","$(LOCATION=location)")
+epicsEnvSet("STARTUP","$(TOP)")
+epicsEnvSet("ST_CMD","st.cmd")
+## Register all support components
+dbLoadDatabase("dbd/hostStats.dbd",0,0)
+hostStats_registerRecordDeviceDriver(pdbbase)
+
+## Host-wide statistics (CPU, memory, load), collected once for all IOCs
+dbLoadRecords("db/iocAdminSoft.db","IOC=$(HOST)")
+## optionally the top process lists
+#dbLoadRecords("db/iocTopProcs.db","IOCNAME=$(HOST)")
+
+## Per-IOC statistics for every IOC running on the host.
+## Scan period and glob pattern for the IOC executable name; without a
+## pattern all processes using the EPICS database library are taken.
+#hostStatsConfig(10, "*Ioc*")
+hostStatsLoadRecords("db/hostStatsIoc.db","HOST=$(HOST)")
+## IOCs started later need their own line
+#dbLoadRecords("db/hostStatsIoc.db","HOST=$(HOST),IOC=xxx")
+
+iocInit()
+
+## The IOCs themselves may now leave out the host-wide collectors:
+##   var devIocStatsHostStats 0
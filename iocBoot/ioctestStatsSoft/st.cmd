@@ -23,8 +23,15 @@ testIocStats_registerRecordDeviceDriver(pdbbase)
 dbLoadRecords("db/iocAdminSoft.db","IOC=IOCTEST")
 ## optionally load the SCAN monitoring records
 #dbLoadRecords("db/iocAdminScanMon.db","IOC=IOCTEST")
+## optionally load the run time of devIocStats itself
+#dbLoadRecords("db/iocAdminTiming.db","IOC=IOCTEST")
+## optionally load the top process lists (Linux)
+#dbLoadRecords("db/iocTopProcs.db","IOCNAME=IOCTEST")
 #dbLoadRecords("db/testIocAdminRelease.db","IOC=IOCTEST")
 
+## optionally serve the statistics to Prometheus on http://localhost:9102/metrics
+#iocStatsHttpStart(9102, "127.0.0.1")
+
 iocInit()
 
 #seq(&testSuspension)
@@ -0,0 +1,188 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* devIocStatsCalibTest.c - Accuracy of sys_cpuload and ioc_cpuload against
+ *                          the vxStats_busyloop() load generator */
+
+/*
+ *  Runs busyloop threads (two if there is more than one CPU) at the duty
+ *  cycles in duties[] and samples the CPU load collectors every interval
+ *  of intervals[] (the cpu_scan_rate), NSAMPLES times.  The intervals in
+ *  longIntervals[] take minutes and only run if the environment variable
+ *  DEVIOCSTATS_CALIB_LONG is set.  The reference is
+ *	expected = idle + sum of the threads' CPU time / number of CPUs
+ *  where idle is the mean load measured at 0% and the threads' CPU time
+ *  comes from the thread CPU-time clock (the nominal duty where there is
+ *  none), as sleep overshoot makes the generated load lower than the
+ *  nominal duty.  The mean of the samples must be within IOC_TOLERANCE
+ *  (ioc_cpuload) or SYS_TOLERANCE (sys_cpuload) percent of one CPU.
+ *  sys_cpuload includes all other processes on the host, so its checks
+ *  are TODO items: reported, but not failing the test.  The largest error
+ *  of each collector and interval is reported as a diagnostic.  The OSD
+ *  implementation tested is the one of the host architecture.
+ *
+ *  The test is a program of its own without an IOC, so initializing the
+ *  collectors only sets up its own collector state.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#include <epicsThread.h>
+#include <epicsEvent.h>
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include "devIocStats.h"
+
+/* devIocStatsTest.c */
+extern double vxStats_busyloop_period;
+extern volatile int vxStats_busyloop_run;
+extern void vxStats_busyloop(unsigned busyperc);
+
+#define MAX_THREADS	2
+#define NSAMPLES	4
+#define IOC_TOLERANCE	5.0	/* % of one CPU */
+#define SYS_TOLERANCE	20.0
+
+typedef struct {
+	unsigned duty;
+	double busy;		/* fraction of one CPU actually used */
+	epicsEventId done;
+} loopArg;
+
+static const unsigned duties[] = { 0, 25, 50, 75, 100 };
+#define NDUTIES (sizeof(duties) / sizeof(duties[0]))
+
+/* sec between samples */
+static const double intervals[] = { 0.2, 0.5 };
+static const double longIntervals[] = { 2.0, 5.0 };
+#define NINTERVALS (sizeof(intervals) / sizeof(intervals[0]))
+#define NLONG (sizeof(longIntervals) / sizeof(longIntervals[0]))
+
+/* -------------------------------------------------------------------- */
+
+static void loopThread(void *arg)
+{
+	loopArg *pa = (loopArg *)arg;
+	double start, cpu, used;
+
+	start = devIocStatsClock();
+	cpu = devIocStatsThreadCpuTime();
+	vxStats_busyloop(pa->duty);
+	used = devIocStatsThreadCpuTime() - cpu;
+	/* No thread CPU-time clock on this OS */
+	pa->busy = used > 0 ? used / (devIocStatsClock() - start) : pa->duty / 100.0;
+	epicsEventSignal(pa->done);
+}
+
+/* Mean of both loads at one duty cycle, returns the generated load in %
+   of all CPUs */
+static double measure(unsigned duty, double interval, int nthreads,
+		      int ncpus, double *pioc, double *psys)
+{
+	loopArg args[MAX_THREADS];
+	loadInfo load;
+	double busy = 0;
+	char name[32];
+	int i;
+
+	/* Many busy/idle periods per sample */
+	vxStats_busyloop_period = interval / 10;
+	vxStats_busyloop_run = 1;
+	for (i = 0; i < nthreads; i++) {
+		args[i].duty = duty;
+		args[i].busy = 0;
+		args[i].done = epicsEventMustCreate(epicsEventEmpty);
+		sprintf(name, "calib%d", i);
+		epicsThreadCreate(name, epicsThreadPriorityLow,
+				  epicsThreadGetStackSize(epicsThreadStackSmall),
+				  loopThread, &args[i]);
+	}
+
+	/* Settle, then take a fresh reference point */
+	epicsThreadSleep(interval);
+	memset(&load, 0, sizeof(load));
+	devIocStatsInitCpuUsage();
+	devIocStatsInitCpuUtilization(&load);
+
+	*pioc = *psys = 0;
+	for (i = 0; i < NSAMPLES; i++) {
+		epicsThreadSleep(interval);
+		devIocStatsGetCpuUsage(&load);
+		devIocStatsGetCpuUtilization(&load);
+		*pioc += load.iocLoad / NSAMPLES;
+		*psys += load.cpuLoad / NSAMPLES;
+	}
+
+	vxStats_busyloop_run = 0;
+	for (i = 0; i < nthreads; i++) {
+		epicsEventMustWait(args[i].done);
+		epicsEventDestroy(args[i].done);
+		busy += args[i].busy;
+	}
+	return 100.0 * busy / ncpus;
+}
+
+/* All duty cycles at one interval */
+static void calibrate(double interval, int nthreads, int ncpus)
+{
+	double ioc, sys, busy, err, iocIdle = 0, sysIdle = 0;
+	double iocMax = 0, sysMax = 0;
+	unsigned i;
+
+	testDiag("samples every %g s", interval);
+	for (i = 0; i < NDUTIES; i++) {
+		busy = measure(duties[i], interval, nthreads, ncpus, &ioc, &sys);
+		if (duties[i] == 0) {
+			iocIdle = ioc;
+			sysIdle = sys;
+			testOk(ioc * ncpus <= IOC_TOLERANCE,
+			       "%g s: ioc_cpuload idle %.2f%% of one CPU",
+			       interval, ioc * ncpus);
+			continue;
+		}
+		/* Errors in % of one CPU */
+		err = fabs(ioc - iocIdle - busy) * ncpus;
+		if (err > iocMax) iocMax = err;
+		testOk(err <= IOC_TOLERANCE,
+		       "%g s: ioc_cpuload at %u%%: %.2f expected %.2f",
+		       interval, duties[i], ioc, iocIdle + busy);
+		err = fabs(sys - sysIdle - busy) * ncpus;
+		if (err > sysMax) sysMax = err;
+		testTodoBegin("includes the other processes on the host");
+		testOk(err <= SYS_TOLERANCE,
+		       "%g s: sys_cpuload at %u%%: %.2f expected %.2f",
+		       interval, duties[i], sys, sysIdle + busy);
+		testTodoEnd();
+	}
+	testDiag("%g s: max |error| ioc_cpuload %.2f, sys_cpuload %.2f (%% of one CPU)",
+		 interval, iocMax, sysMax);
+}
+
+MAIN(devIocStatsCalibTest)
+{
+	int ncpus = devIocStatsNoOfCpus();
+	int nthreads, runLong = getenv("DEVIOCSTATS_CALIB_LONG") != NULL;
+	unsigned i;
+
+	if (ncpus < 1) ncpus = 1;
+	nthreads = ncpus > 1 ? MAX_THREADS : 1;
+
+	testPlan((2 * NDUTIES - 1) * (NINTERVALS + (runLong ? NLONG : 0)));
+	testDiag("%d busyloop threads on %d CPUs, %d samples per duty cycle",
+		 nthreads, ncpus, NSAMPLES);
+
+	for (i = 0; i < NINTERVALS; i++)
+		calibrate(intervals[i], nthreads, ncpus);
+	if (!runLong)
+		testDiag("set DEVIOCSTATS_CALIB_LONG for the intervals of seconds");
+	for (i = 0; runLong && i < NLONG; i++)
+		calibrate(longIntervals[i], nthreads, ncpus);
+	return testDone();
+}
@@ -0,0 +1,131 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* devIocStatsHttpTest.c - The OpenMetrics endpoint of a test IOC, scraped
+ *                         on localhost */
+
+/*
+ *  Starts an IOC without records (the device support init starts the
+ *  collectors' infrastructure), the latency probe and the endpoint on the
+ *  first free port from FIRST_PORT, then checks the reply to GET /metrics
+ *  and to an unknown path.  The IOC environment variable holds characters
+ *  that must be escaped in the ioc label.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <epicsThread.h>
+#include <envDefs.h>
+#include <osiSock.h>
+#include <iocsh.h>
+#include <dbAccess.h>
+#include <dbUnitTest.h>
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include "devIocStats.h"
+
+#define FIRST_PORT 19100
+#define NPORTS 100
+#define IOC_NAME "test\"ioc\\1"
+#define IOC_LABEL "{ioc=\"test\\\"ioc\\\\1\""
+
+void devIocStatsHttpTest_registerRecordDeviceDriver(struct dbBase *);
+
+/* Whole reply to GET <path>, NULL on errors */
+static char *httpGet (int port, const char *path)
+{
+    struct sockaddr_in addr;
+    char request[128];
+    size_t len = 0, size = 65536;
+    char *reply;
+    SOCKET sock;
+    int n;
+
+    if (aToIPAddr("127.0.0.1", (unsigned short)port, &addr)) return NULL;
+    sock = epicsSocketCreate(AF_INET, SOCK_STREAM, 0);
+    if (sock == INVALID_SOCKET) return NULL;
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        epicsSocketDestroy(sock);
+        return NULL;
+    }
+    sprintf(request, "GET %s HTTP/1.0\r\nHost: localhost\r\n\r\n", path);
+    send(sock, request, strlen(request), 0);
+
+    reply = malloc(size);
+    while (reply) {
+        if (len == size - 1) {
+            char *p = realloc(reply, size * 2);
+            if (!p) {
+                free(reply);
+                reply = NULL;
+                break;
+            }
+            reply = p;
+            size *= 2;
+        }
+        n = recv(sock, reply + len, size - 1 - len, 0);
+        if (n <= 0) break;
+        len += n;
+    }
+    if (reply) reply[len] = '\0';
+    epicsSocketDestroy(sock);
+    return reply;
+}
+
+MAIN(devIocStatsHttpTest)
+{
+    char *reply, *body;
+    int port;
+
+    testPlan(10);
+    osiSockAttach();
+    epicsEnvSet("IOC", IOC_NAME);
+
+    testdbPrepare();
+    testdbReadDatabase("devIocStatsHttpTest.dbd", NULL, NULL);
+    devIocStatsHttpTest_registerRecordDeviceDriver(pdbbase);
+    testIocInitOk();
+    iocshCmd("iocStatsLatencyProbe 0.001");
+
+    for (port = FIRST_PORT; port < FIRST_PORT + NPORTS; port++)
+        if (devIocStatsHttpStart(port, "127.0.0.1") == 0) break;
+    testOk(port < FIRST_PORT + NPORTS, "listening on 127.0.0.1:%d", port);
+    if (port == FIRST_PORT + NPORTS) {
+        testSkip(9, "no endpoint");
+        testIocShutdownOk();
+        testdbCleanup();
+        return testDone();
+    }
+    /* Some wakeups for the histogram */
+    epicsThreadSleep(0.5);
+
+    reply = httpGet(port, "/metrics");
+    testOk(reply != NULL, "GET /metrics");
+    if (!reply) reply = calloc(1, 1);
+    body = strstr(reply, "\r\n\r\n");
+    testOk(strncmp(reply, "HTTP/1.0 200 OK\r\n", 17) == 0, "status 200");
+    testOk1(strstr(reply, "Content-Type: application/openmetrics-text") != NULL);
+    testOk1(strstr(reply, "\n# TYPE iocstats_ioc_cpuload gauge\n") != NULL);
+    testOk(strstr(reply, "\niocstats_ioc_cpuload" IOC_LABEL "} ") != NULL,
+           "ioc label escaped");
+    testOk1(strstr(reply, "\n# TYPE iocstats_wakeup_latency_seconds histogram\n") != NULL);
+    testOk1(strstr(reply, "\niocstats_wakeup_latency_seconds_bucket"
+                   IOC_LABEL ",le=\"+Inf\"} ") != NULL);
+    testOk(body && strlen(body) >= 6 &&
+           strcmp(body + strlen(body) - 6, "# EOF\n") == 0, "ends with # EOF");
+    free(reply);
+
+    reply = httpGet(port, "/nothing");
+    testOk(reply && strncmp(reply, "HTTP/1.0 404 ", 13) == 0, "unknown path 404");
+    free(reply);
+
+    testIocShutdownOk();
+    testdbCleanup();
+    return testDone();
+}
@@ -0,0 +1,205 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* devIocStatsReplayTest.c - Linux /proc parsers of the collectors on
+ *                           recorded snapshots */
+
+/*
+ *  replay/host64/0 and replay/host64/1 are snapshots of a 64 CPU host,
+ *  10 seconds apart (see README_devIocStats (14) for the layout).  The
+ *  directory with 100000 open files is made at run time in the build
+ *  directory, as it is not worth keeping in the repository.
+ */
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include "devIocStats.h"
+
+#define HOST64 "../replay/host64"
+#define FD_ROOT "fd100k"
+#define FD_COUNT 100000
+#define INTERVAL 10.0
+
+static double ticks;
+
+static void testClose (double value, double expect, const char *what)
+{
+    testOk(fabs(value - expect) <= 1e-9 * (fabs(expect) + 1.0),
+           "%s = %g (expected %g)", what, value, expect);
+}
+
+/* Set up the collectors on snapshot 0, sample on snapshot 1 */
+static void replayStart (void)
+{
+    loadInfo load;
+
+    testOk1(devIocStatsSetProcRoot(HOST64 "/0") == 0);
+    testOk1(devIocStatsSetTime(0.0) == 0);
+    devIocStatsInitCpuUsage();
+    devIocStatsInitCpuUtilization(&load);
+    devIocStatsInitSysLoad();
+    devIocStatsInitMemUsage();
+    devIocStatsInitFDUsage();
+    devIocStatsInitIOUsage();
+    testOk1(devIocStatsSetProcRoot(HOST64 "/1") == 0);
+    testOk1(devIocStatsSetTime(INTERVAL) == 0);
+}
+
+static void testCpu (void)
+{
+    loadInfo load;
+
+    testDiag("CPU");
+    memset(&load, 0, sizeof(load));
+    testOk1(devIocStatsNoOfCpus() == 64);
+    testOk1(devIocStatsGetCpuUsage(&load) == 0);
+    /* 12000 user + 4000 system ticks on 64 CPUs */
+    testClose(load.cpuLoad, 100.0 * 16000 / ticks / (INTERVAL * 64), "cpuLoad");
+    testOk1(devIocStatsGetCpuUtilization(&load) == 0);
+    /* 400 user + 200 system ticks of the process */
+    testClose(load.iocLoad, 100.0 * 600 / ticks / (INTERVAL * 64), "iocLoad");
+    /* Two threads waited 0.5 s each */
+    testClose(load.iocRunqWait, 1000.0 * 1.0 / INTERVAL, "iocRunqWait");
+}
+
+static void testLoad (void)
+{
+    sysLoadInfo sysLoad;
+
+    testDiag("Load");
+    memset(&sysLoad, 0, sizeof(sysLoad));
+    testOk1(devIocStatsGetSysLoad(&sysLoad) == 0);
+    testClose(sysLoad.loadAvg[0], 32.0 / 64, "loadAvg[0]");
+    testClose(sysLoad.loadAvg[1], 16.0 / 64, "loadAvg[1]");
+    testClose(sysLoad.loadAvg[2], 8.0 / 64, "loadAvg[2]");
+    testOk(sysLoad.runnable == 40 && sysLoad.total == 2000,
+           "runnable %d/%d (expected 40/2000)", sysLoad.runnable, sysLoad.total);
+    /* run_delay grew by 0.1 s on each CPU */
+    testClose(sysLoad.runqWait, 1000.0 * 6.4 / (INTERVAL * 64), "runqWait");
+}
+
+static void testMem (void)
+{
+    memInfo mem;
+
+    testDiag("Memory");
+    memset(&mem, 0, sizeof(mem));
+    testOk1(devIocStatsGetMemUsage(&mem) == 0);
+    testClose(mem.numBytesAlloc, 25000.0 * sysconf(_SC_PAGESIZE), "numBytesAlloc");
+    /* MemFree + Buffers + Cached */
+    testClose(mem.numBytesFree, 151000000.0 * 1024, "numBytesFree");
+    testClose(mem.numBytesTotal, 263921456.0 * 1024, "numBytesTotal");
+}
+
+static void testIO (void)
+{
+    ioInfo io;
+
+    testDiag("I/O");
+    memset(&io, 0, sizeof(io));
+    testOk1(devIocStatsGetIOUsage(&io) == 0);
+    testClose(io.readBytes, 500000 / INTERVAL, "readBytes");
+    testClose(io.writeBytes, 200000 / INTERVAL, "writeBytes");
+    testClose(io.readCalls, 1000 / INTERVAL, "readCalls");
+    testClose(io.writeCalls, 100 / INTERVAL, "writeCalls");
+    testClose(io.diskReadBytes, 409600 / INTERVAL, "diskReadBytes");
+    testClose(io.diskWriteBytes, 204800 / INTERVAL, "diskWriteBytes");
+    /* 50 ticks of delayacct_blkio_ticks, no taskstats when replaying */
+    testClose(io.blkioDelay, 1000.0 * 50 / ticks / INTERVAL, "blkioDelay");
+    testClose(io.cpuDelay, 0.0, "cpuDelay");
+}
+
+static void testFd (void)
+{
+    fdInfo fd;
+
+    testDiag("File descriptors");
+    memset(&fd, 0, sizeof(fd));
+    testOk1(devIocStatsGetFDUsage(&fd) == 0);
+    testOk(fd.used == 5, "used %d (expected 5)", fd.used);
+}
+
+static int makeFdRoot (int count)
+{
+    char path[64];
+    FILE *fp;
+    int i;
+
+    if (mkdir(FD_ROOT, 0755) || mkdir(FD_ROOT "/proc", 0755) ||
+        mkdir(FD_ROOT "/proc/self", 0755) || mkdir(FD_ROOT "/proc/self/fd", 0755))
+        return -1;
+    for (i = 0; i < count; i++) {
+        sprintf(path, FD_ROOT "/proc/self/fd/%d", i);
+        if (!(fp = fopen(path, "w"))) return -1;
+        fclose(fp);
+    }
+    return 0;
+}
+
+static void removeFdRoot (int count)
+{
+    char path[64];
+    int i;
+
+    for (i = 0; i < count; i++) {
+        sprintf(path, FD_ROOT "/proc/self/fd/%d", i);
+        remove(path);
+    }
+    rmdir(FD_ROOT "/proc/self/fd");
+    rmdir(FD_ROOT "/proc/self");
+    rmdir(FD_ROOT "/proc");
+    rmdir(FD_ROOT);
+}
+
+static void testManyFds (void)
+{
+    fdInfo fd;
+    double start;
+    int status;
+
+    testDiag("%d file descriptors", FD_COUNT);
+    removeFdRoot(FD_COUNT);
+    if (makeFdRoot(FD_COUNT)) {
+        testSkip(2, "can't create " FD_ROOT);
+        removeFdRoot(FD_COUNT);
+        return;
+    }
+    memset(&fd, 0, sizeof(fd));
+    testOk1(devIocStatsSetProcRoot(FD_ROOT) == 0);
+    start = devIocStatsClock();
+    status = devIocStatsGetFDUsage(&fd);
+    testDiag("devIocStatsGetFDUsage took %.1f ms", 1e3 * (devIocStatsClock() - start));
+    testOk(status == 0 && fd.used == FD_COUNT,
+           "used %d (expected %d)", fd.used, FD_COUNT);
+    removeFdRoot(FD_COUNT);
+}
+
+MAIN(devIocStatsReplayTest)
+{
+    testPlan(36);
+    ticks = (double)sysconf(_SC_CLK_TCK);
+
+    replayStart();
+    testCpu();
+    testLoad();
+    testMem();
+    testIO();
+    testFd();
+    testManyFds();
+
+    testOk1(devIocStatsSetProcRoot("") == 0);
+    testOk1(devIocStatsSetTime(-1.0) == 0);
+    testOk1(!devIocStatsReplaying());
+    return testDone();
+}
@@ -0,0 +1,330 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* iocStatsBench.c - Microbenchmarks for the devIocStats OSD collectors and
+ *                   device support reads */
+
+/*
+ *  iocStatsBench <file> <nfds> <nthreads> <seconds>
+ *
+ *  Run after iocInit.  Opens extra file descriptors and starts extra idle
+ *  threads until nfds/nthreads of them exist (they are kept, so a series
+ *  of calls with growing numbers gives the scaling), then measures the
+ *  ns/op of every devIocStatsGet* function and of the read routine of
+ *  each distinct "IOC stats" ai, stringin and waveform record (INP).
+ *  Each benchmark runs for about <seconds> (default 0.2).
+ *
+ *  Rows are appended to <file>: JSON lines if the name ends in .json,
+ *  else CSV (with a header for a new file), columns
+ *	benchmark, ops, ns_per_op, fds, threads, records
+ *
+ *  The collectors are held off while the OSD functions are measured, as
+ *  several of them keep state between calls.  The records' values are
+ *  overwritten by the reads.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <epicsThread.h>
+#include <epicsEvent.h>
+#include <dbAccess.h>
+#include <dbStaticLib.h>
+#include <dbCommon.h>
+#include <devSup.h>
+#include <iocsh.h>
+#include <epicsExport.h>
+
+#include "devIocStats.h"
+
+#define MAX_EXTRA_FDS     100000
+#define MAX_EXTRA_THREADS 10000
+#define MIN_OPS           3
+
+typedef struct {
+	long		number;
+	DEVSUPFUN	report;
+	DEVSUPFUN	init;
+	DEVSUPFUN	init_record;
+	DEVSUPFUN	get_ioint_info;
+	DEVSUPFUN	read;
+} readDset;
+
+typedef void (*benchFunc)(void *arg);
+
+typedef struct {
+	FILE *fp;
+	int json;
+	int fds;
+	int threads;
+	long records;
+	double seconds;
+} benchRun;
+
+static int extraFds[MAX_EXTRA_FDS];
+static int nExtraFds = 0;
+static int nExtraThreads = 0;
+static epicsEventId idleEvent = NULL;
+
+/* -------------------------------------------------------------------- */
+
+static void idleThread(void *arg)
+{
+	epicsEventMustWait(idleEvent);
+}
+
+static void addLoad(int nfds, int nthreads)
+{
+	char name[32];
+	int fd;
+
+	while (nExtraFds < nfds && nExtraFds < MAX_EXTRA_FDS) {
+		if ((fd = open("/dev/null", O_RDONLY)) < 0) {
+			printf("iocStatsBench: only %d extra fds\n", nExtraFds);
+			break;
+		}
+		extraFds[nExtraFds++] = fd;
+	}
+	if (!idleEvent) idleEvent = epicsEventMustCreate(epicsEventEmpty);
+	while (nExtraThreads < nthreads && nExtraThreads < MAX_EXTRA_THREADS) {
+		sprintf(name, "bench%d", nExtraThreads);
+		if (!epicsThreadCreate(name, epicsThreadPriorityLow,
+		                       epicsThreadGetStackSize(epicsThreadStackSmall),
+		                       idleThread, NULL)) {
+			printf("iocStatsBench: only %d extra threads\n", nExtraThreads);
+			break;
+		}
+		nExtraThreads++;
+	}
+}
+
+static void emit(benchRun *prun, const char *name, unsigned long ops, double nsPerOp)
+{
+	if (prun->json)
+		fprintf(prun->fp, "{\"benchmark\": \"%s\", \"ops\": %lu, \"ns_per_op\": %.1f, "
+		        "\"fds\": %d, \"threads\": %d, \"records\": %ld}\n",
+		        name, ops, nsPerOp, prun->fds, prun->threads, prun->records);
+	else
+		fprintf(prun->fp, "%s,%lu,%.1f,%d,%d,%ld\n",
+		        name, ops, nsPerOp, prun->fds, prun->threads, prun->records);
+	printf("%-40s %10lu ops %14.1f ns/op\n", name, ops, nsPerOp);
+}
+
+static void bench(benchRun *prun, const char *name, benchFunc func, void *arg)
+{
+	unsigned long ops = 0, batch = 1, i;
+	double start = devIocStatsClock(), elapsed;
+
+	/* Grow the batch so the clock is read rarely for fast functions */
+	do {
+		for (i = 0; i < batch; i++) func(arg);
+		ops += batch;
+		elapsed = devIocStatsClock() - start;
+		if (elapsed < prun->seconds / 10) batch *= 2;
+	} while (elapsed < prun->seconds || ops < MIN_OPS);
+	emit(prun, name, ops, elapsed / ops * 1e9);
+}
+
+/* -------------------------------------------------------------------- */
+
+static void bCpuUsage(void *arg)	{ loadInfo v; devIocStatsGetCpuUsage(&v); }
+static void bCpuUtilization(void *arg)	{ loadInfo v; devIocStatsGetCpuUtilization(&v); }
+static void bSysLoad(void *arg)		{ sysLoadInfo v; devIocStatsGetSysLoad(&v); }
+static void bFDUsage(void *arg)		{ fdInfo v; devIocStatsGetFDUsage(&v); }
+static void bMemUsage(void *arg)	{ memInfo v; devIocStatsGetMemUsage(&v); }
+static void bWorkspaceUsage(void *arg)	{ memInfo v; devIocStatsGetWorkspaceUsage(&v); }
+static void bIOUsage(void *arg)		{ ioInfo v; devIocStatsGetIOUsage(&v); }
+static void bTopProcs(void *arg)	{ static topProcInfo v; devIocStatsGetTopProcs(&v); }
+static void bSuspTasks(void *arg)	{ int v; devIocStatsGetSuspTasks(&v); }
+static void bClusterInfo(void *arg)	{ static clustInfo v; devIocStatsGetClusterInfo(DATA_POOL, &v); }
+static void bClusterUsage(void *arg)	{ int v; devIocStatsGetClusterUsage(DATA_POOL, &v); }
+static void bIFErrors(void *arg)	{ ifErrInfo v; devIocStatsGetIFErrors(&v); }
+static void bBootLine(void *arg)	{ char *v; devIocStatsGetBootLine(&v); }
+static void bStartupScript(void *arg)	{ char *v; devIocStatsGetStartupScript(&v); }
+static void bBSPVersion(void *arg)	{ char *v; devIocStatsGetBSPVersion(&v); }
+static void bKernelVersion(void *arg)	{ char *v; devIocStatsGetKernelVersion(&v); }
+static void bPwd(void *arg)		{ char *v; devIocStatsGetPwd(&v); }
+static void bHostname(void *arg)	{ char *v; devIocStatsGetHostname(&v); }
+static void bPID(void *arg)		{ double v; devIocStatsGetPID(&v); }
+static void bPPID(void *arg)		{ double v; devIocStatsGetPPID(&v); }
+static void bClock(void *arg)		{ devIocStatsClock(); }
+static void bThreadCpuTime(void *arg)	{ devIocStatsThreadCpuTime(); }
+static void bProcStats(void *arg)
+{
+	double pid;
+	procStats v;
+	devIocStatsGetPID(&pid);
+	devIocStatsGetProcStats((int)pid, &v);
+}
+static void bFindIocs(void *arg)
+{
+	static iocProcId v[64];
+	devIocStatsFindIocs(NULL, v, 64);
+}
+
+static struct {
+	char *name;
+	benchFunc func;
+} osdBench[] = {
+	{ "devIocStatsGetCpuUsage",		bCpuUsage },
+	{ "devIocStatsGetCpuUtilization",	bCpuUtilization },
+	{ "devIocStatsGetSysLoad",		bSysLoad },
+	{ "devIocStatsGetFDUsage",		bFDUsage },
+	{ "devIocStatsGetMemUsage",		bMemUsage },
+	{ "devIocStatsGetWorkspaceUsage",	bWorkspaceUsage },
+	{ "devIocStatsGetIOUsage",		bIOUsage },
+	{ "devIocStatsGetTopProcs",		bTopProcs },
+	{ "devIocStatsGetProcStats",		bProcStats },
+	{ "devIocStatsFindIocs",		bFindIocs },
+	{ "devIocStatsGetSuspTasks",		bSuspTasks },
+	{ "devIocStatsGetClusterInfo",		bClusterInfo },
+	{ "devIocStatsGetClusterUsage",		bClusterUsage },
+	{ "devIocStatsGetIFErrors",		bIFErrors },
+	{ "devIocStatsGetBootLine",		bBootLine },
+	{ "devIocStatsGetStartupScript",	bStartupScript },
+	{ "devIocStatsGetBSPVersion",		bBSPVersion },
+	{ "devIocStatsGetKernelVersion",	bKernelVersion },
+	{ "devIocStatsGetPwd",			bPwd },
+	{ "devIocStatsGetHostname",		bHostname },
+	{ "devIocStatsGetPID",			bPID },
+	{ "devIocStatsGetPPID",			bPPID },
+	{ "devIocStatsClock",			bClock },
+	{ "devIocStatsThreadCpuTime",		bThreadCpuTime },
+	{ NULL, NULL }
+};
+
+/* -------------------------------------------------------------------- */
+
+static void bRead(void *arg)
+{
+	dbCommon *prec = (dbCommon *)arg;
+
+	dbScanLock(prec);
+	((readDset *)prec->dset)->read(prec);
+	dbScanUnlock(prec);
+}
+
+/* One benchmark per record type and INP, for the DTYP="IOC stats" records */
+static void benchRecords(benchRun *prun, const char *recordType)
+{
+	DBENTRY dbentry;
+	DBADDR addr;
+	char name[128];
+	char (*done)[64] = NULL;
+	int nDone = 0, i;
+	long status;
+
+	dbInitEntry(pdbbase, &dbentry);
+	if (dbFindRecordType(&dbentry, recordType)) {
+		dbFinishEntry(&dbentry);
+		return;
+	}
+	done = calloc(dbGetNRecords(&dbentry) + 1, sizeof(*done));
+	for (status = dbFirstRecord(&dbentry); !status && done;
+	     status = dbNextRecord(&dbentry)) {
+		const char *inp;
+
+		if (dbFindField(&dbentry, "DTYP") ||
+		    strcmp(dbGetString(&dbentry), "IOC stats") != 0)
+			continue;
+		if (dbFindField(&dbentry, "INP")) continue;
+		inp = dbGetString(&dbentry);
+		if (*inp == '@') inp++;
+		for (i = 0; i < nDone; i++)
+			if (strcmp(done[i], inp) == 0) break;
+		if (i < nDone) continue;
+		strncpy(done[nDone], inp, sizeof(done[0]) - 1);
+		nDone++;
+
+		if (dbNameToAddr(dbGetRecordName(&dbentry), &addr) ||
+		    !addr.precord->dset)
+			continue;
+		sprintf(name, "%s_read:%.60s", recordType, inp);
+		bench(prun, name, bRead, addr.precord);
+	}
+	free(done);
+	dbFinishEntry(&dbentry);
+}
+
+static long countRecords(void)
+{
+	DBENTRY dbentry;
+	long status, n = 0;
+
+	dbInitEntry(pdbbase, &dbentry);
+	for (status = dbFirstRecordType(&dbentry); !status;
+	     status = dbNextRecordType(&dbentry))
+		n += dbGetNRecords(&dbentry);
+	dbFinishEntry(&dbentry);
+	return n;
+}
+
+static void iocStatsBench(const char *file, int nfds, int nthreads, double seconds)
+{
+	benchRun run;
+	fdInfo fds;
+	long size;
+	int i;
+
+	if (!file || !*file || !pdbbase) {
+		printf("Usage: iocStatsBench <file> <nfds> <nthreads> <seconds> (after iocInit)\n");
+		return;
+	}
+	addLoad(nfds, nthreads);
+
+	run.fp = fopen(file, "a");
+	if (!run.fp) {
+		printf("iocStatsBench: can't open %s\n", file);
+		return;
+	}
+	fseek(run.fp, 0, SEEK_END);
+	size = ftell(run.fp);
+	run.json = strlen(file) > 5 && strcmp(file + strlen(file) - 5, ".json") == 0;
+	run.seconds = seconds > 0 ? seconds : 0.2;
+	devIocStatsLockCollectors();
+	devIocStatsGetFDUsage(&fds);
+	devIocStatsUnlockCollectors();
+	run.fds = fds.used;
+	run.threads = nExtraThreads;
+	run.records = countRecords();
+	if (!run.json && size == 0)
+		fprintf(run.fp, "benchmark,ops,ns_per_op,fds,threads,records\n");
+
+	printf("iocStatsBench: %d fds, %d extra threads, %ld records\n",
+	       run.fds, run.threads, run.records);
+	devIocStatsLockCollectors();
+	for (i = 0; osdBench[i].name; i++)
+		bench(&run, osdBench[i].name, osdBench[i].func, NULL);
+	devIocStatsUnlockCollectors();
+	benchRecords(&run, "ai");
+	benchRecords(&run, "stringin");
+	benchRecords(&run, "waveform");
+	fclose(run.fp);
+}
+
+/* -------------------------------------------------------------------- */
+
+static const iocshArg iocStatsBenchArg0 = { "file", iocshArgString };
+static const iocshArg iocStatsBenchArg1 = { "nfds", iocshArgInt };
+static const iocshArg iocStatsBenchArg2 = { "nthreads", iocshArgInt };
+static const iocshArg iocStatsBenchArg3 = { "seconds", iocshArgDouble };
+static const iocshArg * const iocStatsBenchArgs[] = {
+	&iocStatsBenchArg0, &iocStatsBenchArg1, &iocStatsBenchArg2, &iocStatsBenchArg3
+};
+static const iocshFuncDef iocStatsBenchDef = { "iocStatsBench", 4, iocStatsBenchArgs };
+static void iocStatsBenchCall(const iocshArgBuf *args)
+{
+	iocStatsBench(args[0].sval, args[1].ival, args[2].ival, args[3].dval);
+}
+
+static void iocStatsBenchRegister(void)
+{
+	iocshRegister(&iocStatsBenchDef, iocStatsBenchCall);
+}
+epicsExportRegistrar(iocStatsBenchRegister);
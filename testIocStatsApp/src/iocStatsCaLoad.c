@@ -0,0 +1,111 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* iocStatsCaLoad.c - CA client load for scaling tests: monitors the
+ *                    records made by iocStatsScaleRecords */
+
+/*
+ *  Usage: iocStatsCaLoad <prefix> <nstats> <nchannels> [<seconds>]
+ *
+ *  Connects <nchannels> channels to <prefix>:S0 ... <prefix>:S<nstats-1>
+ *  (round robin, so nchannels may exceed nstats), subscribes to value
+ *  changes of each and counts the monitor updates for <seconds>
+ *  (default 30).  Prints the connect time and the monitor rate every
+ *  second and at the end.  Run several instances for more clients.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <epicsTime.h>
+#include <cadef.h>
+
+static unsigned long events = 0;
+static long connected = 0;
+
+static void connectionHandler(struct connection_handler_args args)
+{
+	if (args.op == CA_OP_CONN_UP) connected++;
+	else connected--;
+}
+
+static void eventHandler(struct event_handler_args args)
+{
+	if (args.status == ECA_NORMAL) events++;
+}
+
+static double since(const epicsTimeStamp *start)
+{
+	epicsTimeStamp now;
+
+	epicsTimeGetCurrent(&now);
+	return epicsTimeDiffInSeconds(&now, start);
+}
+
+int main(int argc, char *argv[])
+{
+	chid *chans;
+	char name[256];
+	long nstats, nchan, i;
+	double seconds = 30.0, elapsed, connectTime = -1;
+	unsigned long lastEvents = 0;
+	epicsTimeStamp start, tick;
+
+	if (argc < 4) {
+		fprintf(stderr, "Usage: %s <prefix> <nstats> <nchannels> [<seconds>]\n",
+			argv[0]);
+		return 1;
+	}
+	nstats = atol(argv[2]);
+	nchan = atol(argv[3]);
+	if (argc > 4) seconds = atof(argv[4]);
+	if (nstats <= 0 || nchan <= 0 || seconds <= 0) {
+		fprintf(stderr, "%s: nstats, nchannels and seconds must be > 0\n", argv[0]);
+		return 1;
+	}
+	chans = calloc(nchan, sizeof(chid));
+	if (!chans) return 1;
+
+	/* Callbacks only from ca_pend_event() in this thread */
+	SEVCHK(ca_context_create(ca_disable_preemptive_callback), "ca_context_create");
+
+	epicsTimeGetCurrent(&start);
+	for (i = 0; i < nchan; i++) {
+		sprintf(name, "%.200s:S%ld", argv[1], i % nstats);
+		SEVCHK(ca_create_channel(name, connectionHandler, NULL,
+					 CA_PRIORITY_DEFAULT, &chans[i]),
+		       "ca_create_channel");
+		SEVCHK(ca_create_subscription(DBR_DOUBLE, 1, chans[i], DBE_VALUE,
+					      eventHandler, NULL, NULL),
+		       "ca_create_subscription");
+	}
+	ca_flush_io();
+
+	tick = start;
+	while ((elapsed = since(&start)) < seconds) {
+		ca_pend_event(0.05);
+		if (connectTime < 0 && connected == nchan) {
+			connectTime = since(&start);
+			printf("%ld channels connected in %.3f s\n", nchan, connectTime);
+		}
+		if (since(&tick) >= 1.0) {
+			printf("%6.1f s: %ld/%ld connected, %.0f monitors/s\n",
+			       elapsed, connected, nchan,
+			       (events - lastEvents) / since(&tick));
+			lastEvents = events;
+			epicsTimeGetCurrent(&tick);
+		}
+	}
+
+	if (connectTime < 0)
+		printf("only %ld of %ld channels connected\n", connected, nchan);
+	printf("%lu monitors in %.1f s: %.0f monitors/s, %.2f per channel and s\n",
+	       events, elapsed, events / elapsed, events / elapsed / nchan);
+
+	ca_context_destroy();
+	free(chans);
+	return 0;
+}
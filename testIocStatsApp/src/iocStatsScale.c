@@ -0,0 +1,158 @@
+/*************************************************************************\
+* EPICS BASE Versions 3.13.7
+* and higher are distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* iocStatsScale.c - Record generator and init timing for scaling tests of
+ *                   the devIocStats device support */
+
+/*
+ *  iocStatsScaleRecords <file> <prefix> <nrecords> <nstats>
+ *
+ *  Before iocInit: writes <nrecords> ai records to <file> and loads them.
+ *  <nstats> of them, <prefix>:S0 ... <prefix>:S<nstats-1>, are I/O Intr
+ *  "IOC stats" records cycling through parms from the start to the end
+ *  of the parm table, the others, <prefix>:R<n>, are passive soft records.
+ *  Also starts timing the iocInit phases.
+ *
+ *  iocStatsScaleShow
+ *
+ *  Prints the time iocInit spent initializing the device support (the
+ *  record counting in ai_init), the records (parm lookup in
+ *  ai_init_record) and in total, followed by iocStatsShow(1) with the
+ *  per-cycle collector cost and the read counts and times of the I/O Intr
+ *  fan-out.  Use the iocStatsCaLoad client for the monitor throughput.
+ */
+
+#include <stdio.h>
+
+#include <dbAccess.h>
+#include <initHooks.h>
+#include <iocsh.h>
+#include <epicsExport.h>
+
+#include "devIocStats.h"
+
+/* Parms of all collectors that update, from the top to the bottom of the
+   parm table */
+static const char *parms[] = {
+	"free_bytes", "sys_cpuload", "ioc_cpuload", "load_avg_1",
+	"fd", "ca_clients", "ca_connections", "io_read_rate",
+	"cpu_delay", "swapin_delay"
+};
+#define NPARMS (sizeof(parms) / sizeof(parms[0]))
+
+enum { PHASE_BEGIN, PHASE_DEVSUP, PHASE_RECSUP, PHASE_RECORDS,
+       PHASE_RUNNING, PHASES };
+
+static double phaseTime[PHASES];
+static int hooked = 0;
+static long nRecords = 0, nStats = 0;
+
+static void scaleInitHook(initHookState state)
+{
+	switch (state) {
+	case initHookAtBeginning:	phaseTime[PHASE_BEGIN] = devIocStatsClock(); break;
+	case initHookAfterInitRecSup:	phaseTime[PHASE_RECSUP] = devIocStatsClock(); break;
+	case initHookAfterInitDevSup:	phaseTime[PHASE_DEVSUP] = devIocStatsClock(); break;
+	case initHookAfterInitDatabase:	phaseTime[PHASE_RECORDS] = devIocStatsClock(); break;
+	case initHookAfterIocRunning:	phaseTime[PHASE_RUNNING] = devIocStatsClock(); break;
+	default: break;
+	}
+}
+
+static long iocStatsScaleRecords(const char *file, const char *prefix,
+				 int nrecords, int nstats)
+{
+	FILE *fp;
+	int i;
+
+	if (interruptAccept) {
+		printf("iocStatsScaleRecords: must be called before iocInit\n");
+		return -1;
+	}
+	if (!file || !*file || !prefix || !*prefix || nrecords <= 0) {
+		printf("Usage: iocStatsScaleRecords <file> <prefix> <nrecords> <nstats>\n");
+		return -1;
+	}
+	if (nstats < 0) nstats = 0;
+	if (nstats > nrecords) nstats = nrecords;
+
+	fp = fopen(file, "w");
+	if (!fp) {
+		printf("iocStatsScaleRecords: can't open %s\n", file);
+		return -1;
+	}
+	for (i = 0; i < nstats; i++)
+		fprintf(fp, "record(ai, \"%s:S%d\") {\n"
+			"  field(DTYP, \"IOC stats\")\n"
+			"  field(INP, \"@%s\")\n"
+			"  field(SCAN, \"I/O Intr\")\n"
+			"}\n", prefix, i, parms[i % NPARMS]);
+	for (i = 0; i < nrecords - nstats; i++)
+		fprintf(fp, "record(ai, \"%s:R%d\") {\n"
+			"  field(VAL, \"%d\")\n"
+			"}\n", prefix, i, i);
+	if (fclose(fp)) {
+		printf("iocStatsScaleRecords: can't write %s\n", file);
+		return -1;
+	}
+
+	if (dbLoadRecords(file, NULL)) return -1;
+	nRecords += nrecords;
+	nStats += nstats;
+
+	if (!hooked) {
+		initHookRegister(scaleInitHook);
+		hooked = 1;
+	}
+	return 0;
+}
+
+static void iocStatsScaleShow(void)
+{
+	if (hooked && phaseTime[PHASE_RUNNING] > 0) {
+		printf("%ld generated records, %ld of them IOC stats\n",
+		       nRecords, nStats);
+		printf("iocInit %.3f s: device support init %.3f s, "
+		       "record init %.3f s\n",
+		       phaseTime[PHASE_RUNNING] - phaseTime[PHASE_BEGIN],
+		       phaseTime[PHASE_DEVSUP] - phaseTime[PHASE_RECSUP],
+		       phaseTime[PHASE_RECORDS] - phaseTime[PHASE_DEVSUP]);
+	} else if (hooked) {
+		printf("iocInit not done yet\n");
+	}
+	devIocStatsShow(1);
+}
+
+/* -------------------------------------------------------------------- */
+
+static const iocshArg iocStatsScaleRecordsArg0 = { "file", iocshArgString };
+static const iocshArg iocStatsScaleRecordsArg1 = { "prefix", iocshArgString };
+static const iocshArg iocStatsScaleRecordsArg2 = { "nrecords", iocshArgInt };
+static const iocshArg iocStatsScaleRecordsArg3 = { "nstats", iocshArgInt };
+static const iocshArg * const iocStatsScaleRecordsArgs[] = {
+	&iocStatsScaleRecordsArg0, &iocStatsScaleRecordsArg1,
+	&iocStatsScaleRecordsArg2, &iocStatsScaleRecordsArg3
+};
+static const iocshFuncDef iocStatsScaleRecordsDef = {
+	"iocStatsScaleRecords", 4, iocStatsScaleRecordsArgs
+};
+static void iocStatsScaleRecordsCall(const iocshArgBuf *args)
+{
+	iocStatsScaleRecords(args[0].sval, args[1].sval, args[2].ival, args[3].ival);
+}
+
+static const iocshFuncDef iocStatsScaleShowDef = { "iocStatsScaleShow", 0, NULL };
+static void iocStatsScaleShowCall(const iocshArgBuf *args)
+{
+	iocStatsScaleShow();
+}
+
+static void iocStatsScaleRegister(void)
+{
+	iocshRegister(&iocStatsScaleRecordsDef, iocStatsScaleRecordsCall);
+	iocshRegister(&iocStatsScaleShowDef, iocStatsScaleShowCall);
+}
+epicsExportRegistrar(iocStatsScaleRegister);